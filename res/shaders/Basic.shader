@@ -3,15 +3,19 @@
 
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec2 texCoord;
+layout(location = 2) in vec4 color;
 
 out vec2 v_TexCoord;
+out vec4 v_Color;
 
-uniform mat4 u_MVP;
+// Sprites are batched in world space, so only the view-projection is applied
+#include "ViewData.glsl"
 
 void main()
 {
-    gl_Position =  u_MVP * position;
+    gl_Position =  u_ViewProjection * position;
     v_TexCoord = texCoord;
+    v_Color = color;
 };
 
 #shader fragment
@@ -20,12 +24,12 @@ void main()
 layout(location = 0) out vec4 color;
 
 in vec2 v_TexCoord;
+in vec4 v_Color;
 
-uniform vec4 u_Color;
 uniform sampler2D u_Texture;
 
 void main()
 {
     vec4 texColor = texture(u_Texture, v_TexCoord);
-    color = texColor * u_Color;
+    color = texColor * v_Color;
 };
\ No newline at end of file
@@ -1,3 +1,5 @@
+#keywords USE_TEXTURE
+
 #shader vertex
 #version 330 core
 
@@ -9,13 +11,15 @@ out vec3 v_Normal;
 out vec3 v_FragPos;
 out vec2 v_TexCoord;
 
-uniform mat4 u_MVP;
+#include "ViewData.glsl"
+
 uniform mat4 u_Model;
 
 void main()
 {
-    gl_Position = u_MVP * vec4(position, 1.0);
-    v_FragPos = vec3(u_Model * vec4(position, 1.0));
+    vec4 worldPos = u_Model * vec4(position, 1.0);
+    gl_Position = u_ViewProjection * worldPos;
+    v_FragPos = vec3(worldPos);
     v_TexCoord = texCoord;
     
     // Transform normal to world space (assuming uniform scaling)
@@ -31,43 +35,22 @@ in vec3 v_Normal;
 in vec3 v_FragPos;
 in vec2 v_TexCoord;
 
+#include "Lighting.glsl"
+
 uniform vec3 u_Color;
-uniform vec3 u_LightPos;
-uniform vec3 u_ViewPos;
-uniform bool u_UseTexture;
+#ifdef USE_TEXTURE
 uniform sampler2D u_Texture;
+#endif
 
 void main()
 {
-    // Basic Phong lighting
-    vec3 lightColor = vec3(1.0, 1.0, 1.0);
-    
-    // Ambient
-    float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * lightColor;
-    
-    // Diffuse
-    vec3 norm = normalize(v_Normal);
-    vec3 lightDir = normalize(u_LightPos - v_FragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
-    
-    // Specular
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(u_ViewPos - v_FragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * lightColor;
-    
-    // Choose between texture and solid color
-    vec3 baseColor;
-    if (u_UseTexture) {
-        vec4 texColor = texture(u_Texture, v_TexCoord);
-        baseColor = texColor.rgb;
-    } else {
-        baseColor = u_Color;
-    }
+    // Texture or solid color, chosen per variant at compile time
+#ifdef USE_TEXTURE
+    vec3 baseColor = texture(u_Texture, v_TexCoord).rgb;
+#else
+    vec3 baseColor = u_Color;
+#endif
     
-    vec3 result = (ambient + diffuse + specular) * baseColor;
+    vec3 result = PhongLighting(v_Normal, v_FragPos) * baseColor;
     color = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,82 @@
+#keywords USE_TEXTURE USE_TEXTURE_ARRAY
+
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+
+// Per-instance attributes (divisor 1)
+layout(location = 3) in vec4 i_PositionScale; // world position (xyz), uniform scale (w)
+layout(location = 4) in vec4 i_Rotation;      // rotation axis (xyz), angle in radians (w)
+layout(location = 5) in float i_Layer;        // texture array layer
+
+out vec3 v_Normal;
+out vec3 v_FragPos;
+out vec2 v_TexCoord;
+flat out float v_Layer;
+
+#include "ViewData.glsl"
+
+// Rodrigues' rotation formula as a matrix
+mat3 AxisAngle(vec3 axis, float angle)
+{
+    float s = sin(angle);
+    float c = cos(angle);
+    float t = 1.0 - c;
+    vec3 a = axis;
+    return mat3(
+        t * a.x * a.x + c,       t * a.x * a.y + s * a.z, t * a.x * a.z - s * a.y,
+        t * a.x * a.y - s * a.z, t * a.y * a.y + c,       t * a.y * a.z + s * a.x,
+        t * a.x * a.z + s * a.y, t * a.y * a.z - s * a.x, t * a.z * a.z + c
+    );
+}
+
+void main()
+{
+    mat3 rotation = AxisAngle(i_Rotation.xyz, i_Rotation.w);
+    vec3 worldPos = rotation * (position * i_PositionScale.w) + i_PositionScale.xyz;
+
+    gl_Position = u_ViewProjection * vec4(worldPos, 1.0);
+    v_FragPos = worldPos;
+    v_TexCoord = texCoord;
+    v_Layer = i_Layer;
+
+    // Rotation only, so normals need no inverse-transpose
+    v_Normal = rotation * normal;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_Normal;
+in vec3 v_FragPos;
+in vec2 v_TexCoord;
+flat in float v_Layer;
+
+#include "Lighting.glsl"
+
+uniform vec3 u_Color;
+#if defined(USE_TEXTURE_ARRAY)
+uniform sampler2DArray u_Texture;     // same unit, array type
+#elif defined(USE_TEXTURE)
+uniform sampler2D u_Texture;
+#endif
+
+void main()
+{
+    // Per-instance layer, one texture, or solid color, chosen per variant at compile time
+#if defined(USE_TEXTURE_ARRAY)
+    vec3 baseColor = texture(u_Texture, vec3(v_TexCoord, v_Layer)).rgb;
+#elif defined(USE_TEXTURE)
+    vec3 baseColor = texture(u_Texture, v_TexCoord).rgb;
+#else
+    vec3 baseColor = u_Color;
+#endif
+
+    vec3 result = PhongLighting(v_Normal, v_FragPos) * baseColor;
+    color = vec4(result, 1.0);
+}
@@ -0,0 +1,7 @@
+// Shared per-frame block (binding 0)
+layout(std140) uniform FrameData
+{
+    vec3 u_LightPos;
+    float u_Time;
+    vec3 u_LightColor;
+};
@@ -0,0 +1,28 @@
+// Phong lighting shared by the lit shaders
+#include "FrameData.glsl"
+#include "ViewData.glsl"
+
+// Light reaching a surface point, to be multiplied by its base color
+vec3 PhongLighting(vec3 normal, vec3 fragPos)
+{
+    vec3 lightColor = u_LightColor;
+
+    // Ambient
+    float ambientStrength = 0.3;
+    vec3 ambient = ambientStrength * lightColor;
+
+    // Diffuse
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(u_LightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * lightColor;
+
+    // Specular
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(u_ViewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * lightColor;
+
+    return ambient + diffuse + specular;
+}
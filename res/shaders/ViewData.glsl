@@ -0,0 +1,8 @@
+// Shared per-view block (binding 1), uploaded once per frame
+layout(std140) uniform ViewData
+{
+    mat4 u_View;
+    mat4 u_Projection;
+    mat4 u_ViewProjection;
+    vec3 u_ViewPos;
+};
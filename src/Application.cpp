@@ -7,6 +7,8 @@
 
 #include "Config.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "GLDebug.h"
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
 #include "VertexArray.h"
@@ -14,12 +16,30 @@
 #include "Shader.h"
 #include "Texture.h"
 #include "Cube.h"
+#include "InstancedCube.h"
+#include "SpriteBatch.h"
+#include "StreamBuffer.h"
+#include "UniformBuffer.h"
+#include "Framebuffer.h"
+#include "HeadlessContext.h"
+#include "GPUProfiler.h"
+#include "ShaderCache.h"
+#include "ShaderReloader.h"
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+#include "TextureAtlas.h"
+#include "AssetPack.h"
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -41,8 +61,10 @@ static void FramebufferSizeCallback(GLFWwindow* /*window*/, int width, int heigh
 
 /**
  * @brief Constructs the OpenGLApp and initializes member variables.
+ * @param options Command line options; scene selection is applied here
  */
-OpenGLApp::OpenGLApp()
+OpenGLApp::OpenGLApp(const AppOptions& options)
+    : options(options)
 {
     translationA = glm::vec3(-400.0f, 0.0f, 0.0f);
     translationB = glm::vec3(400.0f, 0.0f, 0.0f);
@@ -56,6 +78,16 @@ OpenGLApp::OpenGLApp()
     view3D = glm::mat4(1.0f);
     cubeRotationX = 0.0f;
     cubeRotationY = 0.0f;
+
+    spriteCount = std::max(options.sprites, 0);
+    showQuads = !options.noQuads;
+    showCube = options.cube || options.instances > 0;
+    if (options.instances > 0)
+    {
+        cubeInstanced = true;
+        cubeInstanceCount = std::min(options.instances, MAX_CUBE_INSTANCES);
+    }
+    cubeMixedMeshes = options.mixedMeshes;
 }
 
 /**
@@ -72,6 +104,29 @@ OpenGLApp::~OpenGLApp()
  */
 bool OpenGLApp::Initialize()
 {
+    if (options.headless)
+    {
+        if (!InitializeHeadless()) return false;
+        if (!InitializeOpenGL()) return false;
+
+        // No window (or an invisible one): draw into an offscreen target of
+        // the usual window size so the workload matches the interactive app
+        try
+        {
+            offscreen = std::make_unique<Framebuffer>(WINDOW_WIDTH, WINDOW_HEIGHT);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Failed to create offscreen framebuffer: " << e.what() << std::endl;
+            return false;
+        }
+        offscreen->Bind();
+
+        if (!SetupScene()) return false;
+        lastFrameTime = 0.0;
+        return true;
+    }
+
     if (!InitializeGLFW()) return false;
     if (!InitializeOpenGL()) return false;
     if (!InitializeImGui()) return false;
@@ -84,10 +139,15 @@ bool OpenGLApp::Initialize()
 }
 
 /**
- * @brief Main loop. Updates and renders until window is closed.
+ * @brief Main loop. Updates and renders until window is closed, or runs the
+ *        benchmark in headless mode.
+ * @return Process exit code
  */
-void OpenGLApp::Run()
+int OpenGLApp::Run()
 {
+    if (options.headless)
+        return RunBenchmark();
+
     while (window && !glfwWindowShouldClose(window))
     {
         Update();
@@ -96,6 +156,52 @@ void OpenGLApp::Run()
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    return 0;
+}
+
+/**
+ * @brief Creates a context without a visible window.
+ *
+ * Tries EGL first (surfaceless on Mesa, so no display server is needed),
+ * then falls back to a hidden GLFW window. Either way vsync plays no part:
+ * frames go to an offscreen framebuffer and are never presented.
+ *
+ * @return true if a context is current, false otherwise.
+ */
+bool OpenGLApp::InitializeHeadless()
+{
+    headlessContext = std::make_unique<HeadlessContext>();
+    if (headlessContext->Create(3, 3))
+    {
+        contextDescription = headlessContext->GetDescription();
+        return true;
+    }
+    headlessContext.reset();
+
+    glfwSetErrorCallback(GLFWErrorCallback);
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW (and EGL is unavailable)" << std::endl;
+        return false;
+    }
+    glfwInitialized = true;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "OpenGL Benchmark", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "Failed to create hidden GLFW window" << std::endl;
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    contextDescription = "GLFW hidden window";
+    return true;
 }
 
 /**
@@ -116,6 +222,10 @@ bool OpenGLApp::InitializeGLFW()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if GL_DEBUG_LEVEL > GL_DEBUG_LEVEL_OFF
+    // Debug contexts report through KHR_debug far more reliably
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
     window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "OpenGL Application", nullptr, nullptr);
     if (!window)
@@ -146,13 +256,29 @@ bool OpenGLApp::InitializeOpenGL()
 {
     // Required for core profile to get proper function pointers
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK)
+    GLenum glewStatus = glewInit();
+    // GLEW also tries to load GLX extensions, which fails without an X
+    // display; the GL entry points are loaded by then and work with EGL
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY && headlessContext)
+        glewStatus = GLEW_OK;
+    if (glewStatus != GLEW_OK)
     {
-        std::cerr << "Failed to initialize GLEW" << std::endl;
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(glewStatus) << std::endl;
         return false;
     }
 
-    std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
+    // The headless report goes to stdout, so keep diagnostics out of its way
+    std::ostream& out = options.headless ? std::clog : std::cout;
+    out << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
+
+    // glewInit on a core profile leaves a stale GL_INVALID_ENUM behind
+    while (glGetError() != GL_NO_ERROR) {}
+
+#if GL_DEBUG_LEVEL > GL_DEBUG_LEVEL_OFF
+    // With call tracing, report synchronously so the call history ends at the culprit
+    if (!GLDebug::EnableDebugOutput(GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE))
+        out << "KHR_debug not available, relying on glGetError checks" << std::endl;
+#endif
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -192,40 +318,184 @@ bool OpenGLApp::InitializeImGui()
 }
 
 /**
- * @brief Sets up the scene: geometry, buffers, shader, texture, renderer.
- * @return true if successful, false otherwise.
+ * @brief Generates a square pyramid in the cube's vertex format.
+ *
+ * Faces are flat shaded, so every face has its own vertices.
+ *
+ * @param size Side length of the base and height of the pyramid
+ * @param vertices Receives position(3), normal(3), texCoord(2) per vertex
+ * @param indices Receives triangle indices relative to the first vertex
  */
-bool OpenGLApp::SetupScene()
+static void BuildPyramid(float size, std::vector<float>& vertices, std::vector<unsigned int>& indices)
 {
-    // Vertex positions and texture coordinates for a quad
-    float positions[] = {
-        600.0f, QUAD_Y_POS, 0.0f, 0.0f,
-        600.0f + QUAD_SIZE, QUAD_Y_POS, 1.0f, 0.0f,
-        600.0f + QUAD_SIZE, QUAD_Y_POS + QUAD_HEIGHT, 1.0f, 1.0f,
-        600.0f, QUAD_Y_POS + QUAD_HEIGHT, 0.0f, 1.0f
+    const float h = size * 0.5f;
+    const glm::vec3 apex(0.0f, h, 0.0f);
+    const glm::vec3 base[4] = {
+        { -h, -h,  h }, {  h, -h,  h }, {  h, -h, -h }, { -h, -h, -h }
+    };
+
+    auto addVertex = [&](const glm::vec3& p, const glm::vec3& n, float u, float v)
+    {
+        vertices.insert(vertices.end(), { p.x, p.y, p.z, n.x, n.y, n.z, u, v });
     };
 
-    unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+    // Base, facing down
+    const glm::vec3 down(0.0f, -1.0f, 0.0f);
+    addVertex(base[3], down, 0.0f, 0.0f);
+    addVertex(base[2], down, 1.0f, 0.0f);
+    addVertex(base[1], down, 1.0f, 1.0f);
+    addVertex(base[0], down, 0.0f, 1.0f);
+    indices.insert(indices.end(), { 0, 1, 2, 2, 3, 0 });
 
+    // Four sides, counter-clockwise seen from outside
+    for (unsigned int side = 0; side < 4; ++side)
+    {
+        const glm::vec3& a = base[side];
+        const glm::vec3& b = base[(side + 1) % 4];
+        const glm::vec3 normal = glm::normalize(glm::cross(b - a, apex - a));
+        const unsigned int first = static_cast<unsigned int>(vertices.size() / 8);
+        addVertex(a, normal, 0.0f, 0.0f);
+        addVertex(b, normal, 1.0f, 0.0f);
+        addVertex(apex, normal, 0.5f, 1.0f);
+        indices.insert(indices.end(), { first, first + 1, first + 2 });
+    }
+}
+
+/**
+ * @brief Sets up the scene: geometry, buffers, shader, texture, renderer.
+ * @return true if successful, false otherwise.
+ */
+bool OpenGLApp::SetupScene()
+{
+    double shaderWaitMs = 0.0;
     try
     {
-        va = std::make_unique<VertexArray>();
-        vb = std::make_unique<VertexBuffer>(positions, 4 * 4 * sizeof(float));
+        // The renderer owns the stream buffer the batched/instanced paths write into
+        renderer = std::make_unique<Renderer>(STREAM_BUFFER_FRAME_SIZE);
+        gpuProfiler = std::make_unique<GPUProfiler>();
+
+        // Member order must match res/shaders/FrameData.glsl and ViewData.glsl
+        UniformBufferLayout frameLayout;
+        frameLayout.Push<glm::vec3>("u_LightPos");
+        frameLayout.Push<float>("u_Time");
+        frameLayout.Push<glm::vec3>("u_LightColor");
+        frameUniforms = std::make_unique<UniformBuffer>(frameLayout, UNIFORM_BLOCK_FRAME.binding);
 
-        VertexBufferLayout layout;
-        layout.Push<float>(2); // position
-        layout.Push<float>(2); // tex coords
-        va->AddBuffer(*vb, layout);
+        UniformBufferLayout viewLayout;
+        viewLayout.Push<glm::mat4>("u_View");
+        viewLayout.Push<glm::mat4>("u_Projection");
+        viewLayout.Push<glm::mat4>("u_ViewProjection");
+        viewLayout.Push<glm::vec3>("u_ViewPos");
+        viewUniforms3D = std::make_unique<UniformBuffer>(viewLayout, UNIFORM_BLOCK_VIEW.binding);
+        viewUniforms2D = std::make_unique<UniformBuffer>(viewLayout, UNIFORM_BLOCK_VIEW.binding);
 
-        ib = std::make_unique<IndexBuffer>(indices, 6);
+        // With --pack, one mapping instead of opening each shader and image;
+        // anything the pack lacks is read from the loose files under res/
+        if (!options.assetPack.empty() && !AssetPack::Mount(options.assetPack))
+            std::cerr << "Cannot open asset pack " << options.assetPack << ", reading res/" << std::endl;
 
+        // Submit every program first: the driver compiles and links them on
+        // its own threads while the texture is decoded and the meshes built
         shader = std::make_unique<Shader>("res/shaders/Basic.shader");
-        texture = std::make_unique<Texture>("res/textures/myimage.png");
-        renderer = std::make_unique<Renderer>();
+        cubeShader = std::make_unique<Shader>("res/shaders/Cube.shader");
+        cubeInstancedShader = std::make_unique<Shader>("res/shaders/CubeInstanced.shader");
+
+        // 2D quads are batched; the basic shader takes position, tex coords and color.
+        // The texture shows a placeholder until a loader thread has decoded it
+        // and built its mip chain (read from res/textures/*.mips after the first run).
+        spriteBatch = std::make_unique<SpriteBatch>(renderer->GetStreamBuffer());
+        textureAnisotropy = std::min(textureAnisotropy, Texture::GetMaxAnisotropy());
+        Texture::SetDefaultAnisotropy(textureAnisotropy);
+        textureLoader = std::make_unique<TextureLoader>();
+        if (options.noCompression)
+            textureLoader->SetCompression(false);
+        // Streamed, it starts at 64x64 and sharpens as far as the quads and
+        // cubes drawing it need (--stream-textures)
+        auto loadTexture = [this](const char* path) {
+            return options.streamTextures ? textureLoader->LoadStreamed(path) : textureLoader->Load(path);
+        };
+        texture = loadTexture("res/textures/myimage.png");
         
         // Initialize 3D cube resources
         cube = std::make_unique<Cube>(1.0f);
-        cubeShader = std::make_unique<Shader>("res/shaders/Cube.shader");
+        cubeInstances = std::make_unique<InstancedCube>(*cube, renderer->GetStreamBuffer(), MAX_CUBE_INSTANCES);
+
+        // Whatever the overlap didn't hide is waited for here, in completion order
+        const auto waitStart = std::chrono::steady_clock::now();
+        Shader::FinishBuilds({ shader.get(), cubeShader.get(), cubeInstancedShader.get() });
+        shaderWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+
+        // The benchmark measures the finished scene; interactively the image
+        // simply appears a frame or two in
+        if (options.headless)
+            textureLoader->Finish();
+
+        // Stress test: cycle through the bundled images, uploaded while running
+        static const char* const stressImages[] = {
+            "res/textures/myimage.png", "res/textures/eula.png", "res/textures/aru.png"
+        };
+
+        // The sprites draw all three from one page. They are tiny, so the
+        // padding is wide enough for the mips to reach about their size.
+        spriteAtlas = std::make_unique<TextureAtlas>(TextureAtlas::DefaultPageSize, 32);
+        for (const char* image : stressImages)
+            spriteAtlas->Add(image);
+        spriteAtlas->Build("res/textures/sprites.atlas");
+
+        // The 512x512 images share one array, so the instances can cycle
+        // through them without a rebind
+        textureArrays = std::make_unique<TextureArrayManager>();
+        for (const char* image : { "res/textures/myimage.png", "res/textures/eula.png", "res/textures/myimage.jpg" })
+        {
+            const TextureLayer layer = textureArrays->Load(image);
+            if (layer.IsValid() && (cubeLayers.empty() || layer.array == cubeLayers[0].array))
+                cubeLayers.push_back(layer);
+        }
+        for (int i = 0; i < options.loadTextures; i++)
+            loadedTextures.push_back(loadTexture(stressImages[i % 3]));
+        if (options.textureBudget > 0)
+        {
+            textureBudgetMB = options.textureBudget;
+            textureResidency = std::make_unique<TextureResidency>(*textureLoader, size_t(textureBudgetMB) << 20);
+            textureResidency->Add(*texture);
+            for (const auto& loaded : loadedTextures)
+                textureResidency->Add(*loaded);
+        }
+
+        // Unknown names are reported here rather than on every frame
+        auto resolveCubeUniforms = [](const Shader& source, CubeUniforms& target) {
+            target.color = source.GetUniform("u_Color");
+            target.texture = source.GetUniform("u_Texture");
+            target.textureVariant = source.GetKeyword("USE_TEXTURE");
+        };
+        resolveCubeUniforms(*cubeShader, cubeUniforms);
+        resolveCubeUniforms(*cubeInstancedShader, cubeInstancedUniforms);
+        cubeInstancedUniforms.textureArrayVariant = cubeInstancedShader->GetKeyword("USE_TEXTURE_ARRAY");
+
+        // Edits to the loose files would not be seen through a pack
+        if (!options.headless && !AssetPack::GetMounted())
+        {
+            shaderReloader = std::make_unique<ShaderReloader>();
+            shaderReloader->Add(*shader);
+            shaderReloader->Add(*cubeShader);
+            shaderReloader->Add(*cubeInstancedShader);
+        }
+
+        // Every mesh of the mixed scene lives in one vertex/index buffer pair
+        std::vector<float> pyramidVertices;
+        std::vector<unsigned int> pyramidIndices;
+        BuildPyramid(1.0f, pyramidVertices, pyramidIndices);
+
+        meshRegistry = std::make_unique<MeshRegistry>(renderer->GetStreamBuffer(), Cube::GetVertexLayout(), 1024, 4096);
+        cubeMesh = meshRegistry->Add(cube->GetVertexData(), Cube::GetVertexCount(), cube->GetIndexData(), Cube::GetIndexCount());
+        pyramidMesh = meshRegistry->Add(pyramidVertices.data(), static_cast<unsigned int>(pyramidVertices.size() / 8),
+                                        pyramidIndices.data(), static_cast<unsigned int>(pyramidIndices.size()));
+
+        VertexBufferLayout instanceLayout(1);
+        instanceLayout.Push<float>(4); // position (xyz), scale (w)
+        instanceLayout.Push<float>(4); // rotation axis (xyz), angle (w)
+        instanceLayout.Push<float>(1); // texture array layer
+        meshRegistry->SetInstanceLayout(instanceLayout);
     }
     catch (const std::exception& e)
     {
@@ -247,9 +517,15 @@ bool OpenGLApp::SetupScene()
                          glm::vec3(0.0f, 0.0f, 0.0f),   // Look at origin
                          glm::vec3(0.0f, 1.0f, 0.0f));  // Up vector
 
-    if (shader) shader->Bind();
-    if (texture) texture->Bind();
-    if (shader) shader->SetUniform1i("u_Texture", 0);
+    // Startup cost of the shaders above (summed per program, and the part of
+    // it startup actually waited for), and how much the binary cache saved
+    const ShaderCacheStats& cacheStats = ShaderCache::GetStats();
+    (options.headless ? std::clog : std::cout)
+        << "Shaders: " << cacheStats.hits << " from cache, " << cacheStats.misses << " compiled"
+        << (cacheStats.rejected ? " (" + std::to_string(cacheStats.rejected) + " stale)" : std::string())
+        << " in " << cacheStats.milliseconds << " ms (" << shaderWaitMs << " ms waited"
+        << (Shader::IsParallelCompileSupported() ? ", parallel" : "") << ")"
+        << (ShaderCache::IsSupported() ? "" : " (program binaries not supported)") << std::endl;
 
     sceneSetup = true;
     return true;
@@ -260,12 +536,21 @@ bool OpenGLApp::SetupScene()
  */
 void OpenGLApp::Update()
 {
-    if (!glfwInitialized)
-        return;
+    if (options.headless)
+    {
+        // Fixed step so every benchmark run animates the same workload
+        deltaTime = 1.0f / 60.0f;
+        lastFrameTime += deltaTime;
+    }
+    else
+    {
+        if (!glfwInitialized)
+            return;
 
-    double currentTime = glfwGetTime();
-    deltaTime = static_cast<float>(currentTime - lastFrameTime);
-    lastFrameTime = currentTime;
+        double currentTime = glfwGetTime();
+        deltaTime = static_cast<float>(currentTime - lastFrameTime);
+        lastFrameTime = currentTime;
+    }
 
     // Animate colorValue between 0.75 and 1.0 in a frame-rate independent way
     const float minVal = 0.75f;
@@ -292,6 +577,120 @@ void OpenGLApp::Update()
         // Keep rotations within 0-360 degrees for cleaner values
         if (cubeRotationX >= 360.0f) cubeRotationX -= 360.0f;
         if (cubeRotationY >= 360.0f) cubeRotationY -= 360.0f;
+        
+        if (cubeInstanced)
+            UpdateCubeInstances();
+    }
+    
+    if (showQuads)
+        UpdateSprites();
+}
+
+/**
+ * @brief Moves the stress-test sprites, bouncing them off the window edges.
+ * 
+ * Sprites are added or removed to match spriteCount; new ones get a
+ * pseudo-random position, velocity and spin.
+ */
+void OpenGLApp::UpdateSprites()
+{
+    const size_t target = static_cast<size_t>(spriteCount);
+    if (sprites.size() != target)
+    {
+        unsigned int seed = static_cast<unsigned int>(sprites.size()) * 2654435761u + 1u;
+        auto random = [&seed](float minVal, float maxVal) {
+            seed = seed * 1664525u + 1013904223u;
+            return minVal + (maxVal - minVal) * (static_cast<float>(seed >> 8) / 16777216.0f);
+        };
+        
+        while (sprites.size() < target)
+        {
+            MovingSprite sprite;
+            sprite.position = glm::vec2(random(0.0f, static_cast<float>(WINDOW_WIDTH)),
+                                        random(0.0f, static_cast<float>(WINDOW_HEIGHT)));
+            sprite.velocity = glm::vec2(random(-200.0f, 200.0f), random(-200.0f, 200.0f));
+            sprite.rotation = random(0.0f, 6.2831853f);
+            sprite.spin = random(-3.0f, 3.0f);
+            sprite.image = spriteAtlas && spriteAtlas->GetRegionCount() > 0
+                ? static_cast<unsigned int>(sprites.size() % spriteAtlas->GetRegionCount()) : 0;
+            sprites.push_back(sprite);
+        }
+        sprites.resize(target);
+    }
+
+    const float width = static_cast<float>(WINDOW_WIDTH);
+    const float height = static_cast<float>(WINDOW_HEIGHT);
+    for (MovingSprite& sprite : sprites)
+    {
+        sprite.position += sprite.velocity * deltaTime;
+        sprite.rotation += sprite.spin * deltaTime;
+        if (sprite.position.x < 0.0f || sprite.position.x > width)  sprite.velocity.x = -sprite.velocity.x;
+        if (sprite.position.y < 0.0f || sprite.position.y > height) sprite.velocity.y = -sprite.velocity.y;
+    }
+}
+
+/**
+ * @brief Places cubeInstanceCount cubes on a grid filling the single cube's volume.
+ * 
+ * Positions, scales and rotation axes only change when the instance
+ * count changes; the per-frame update only advances the angles.
+ */
+void OpenGLApp::LayoutCubeInstances()
+{
+    const int count = cubeInstanceCount;
+    const int side = static_cast<int>(std::ceil(std::cbrt(static_cast<float>(count))));
+    const float extent = 3.0f;                    // the grid spans [-1.5, 1.5] on each axis
+    const float spacing = extent / static_cast<float>(side);
+    const float scale = spacing * 0.6f;
+    const float origin = -0.5f * spacing * static_cast<float>(side - 1);
+
+    cubeInstanceData.resize(count);
+    float nearest = 100.0f;
+    unsigned int seed = 12345u;
+    for (int i = 0; i < count; ++i)
+    {
+        const int x = i % side;
+        const int y = (i / side) % side;
+        const int z = i / (side * side);
+
+        // Cheap LCG for a stable pseudo-random axis and phase per instance
+        glm::vec3 axis;
+        for (int c = 0; c < 3; ++c)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            axis[c] = static_cast<float>(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+        }
+        if (glm::dot(axis, axis) < 1e-4f)
+            axis = glm::vec3(0.0f, 1.0f, 0.0f);
+        seed = seed * 1664525u + 1013904223u;
+        const float phase = static_cast<float>(seed >> 8) / 16777216.0f * 6.2831853f;
+
+        CubeInstance& instance = cubeInstanceData[i];
+        instance.positionScale = glm::vec4(origin + spacing * x, origin + spacing * y, origin + spacing * z, scale);
+        instance.rotation = glm::vec4(glm::normalize(axis), phase);
+        instance.layer = cubeLayers.empty() ? 0.0f : static_cast<float>(cubeLayers[i % cubeLayers.size()].layer);
+        nearest = std::min(nearest, -(view3D * glm::vec4(glm::vec3(instance.positionScale), 1.0f)).z);
+    }
+
+    // The camera doesn't move, so the nearest instance's size on screen holds
+    cubeInstanceFootprint = GetFootprint(scale, std::max(nearest, 0.1f));
+}
+
+/**
+ * @brief Advances every instance's rotation. The data is streamed to the GPU in RenderCube.
+ */
+void OpenGLApp::UpdateCubeInstances()
+{
+    if (!cubeInstances) return;
+
+    if (static_cast<int>(cubeInstanceData.size()) != cubeInstanceCount)
+        LayoutCubeInstances();
+
+    const float step = glm::radians(cubeRotationSpeed) * deltaTime;
+    for (CubeInstance& instance : cubeInstanceData)
+    {
+        instance.rotation.w += step;
+        if (instance.rotation.w >= 6.2831853f) instance.rotation.w -= 6.2831853f;
     }
 }
 
@@ -301,7 +700,20 @@ void OpenGLApp::Update()
 void OpenGLApp::Render()
 {
     if (!renderer) return; // ensure resources exist
-    renderer->Clear();
+    if (shaderReloader)
+        shaderReloader->Update();
+    if (textureLoader)
+        textureLoader->Update();
+    if (textureResidency)
+        textureResidency->Update();
+    GLState::BeginFrame();
+    renderer->BeginFrame();
+    gpuProfiler->BeginFrame();
+    {
+        GPUProfileScope scope(gpuProfiler.get(), "Clear");
+        renderer->Clear();
+    }
+    UploadUniformBlocks();
 
     // Start ImGui frame if initialized
     if (imguiInitialized)
@@ -311,86 +723,226 @@ void OpenGLApp::Render()
         ImGui::NewFrame();
     }
 
-    // Render cube first (3D content with depth testing)
-    if (showCube && cube && cubeShader && renderer)
+    // Queue cube (3D content with depth testing)
     {
-        RenderCube();
+        GPUProfileScope scope(gpuProfiler.get(), "Cube pass");
+        viewUniforms3D->Bind();
+        if (showCube && cube && cubeShader && renderer)
+        {
+            RenderCube();
+        }
+
+        // Sort the queued packets by state and issue the draws
+        renderer->Flush();
     }
-    
-    // Render 2D quads with depth testing disabled
-    if (showQuads && va && ib && shader && renderer)
+
+    // 2D quads are batched and drawn on top of the 3D scene
+    if (showQuads && spriteBatch && shader)
     {
-        // Temporarily disable depth testing for 2D content
-        glDisable(GL_DEPTH_TEST);
-        
-        shader->Bind();
-        shader->SetUniform4f("u_Color", colorValue, 1.0f, 1.0f, 1.0f);
-        
-        RenderQuad(translationA);
-        RenderQuad(translationB);
-        
-        // Re-enable depth testing
-        glEnable(GL_DEPTH_TEST);
+        GPUProfileScope scope(gpuProfiler.get(), "Quad pass");
+        viewUniforms2D->Bind();
+        spriteBatch->Begin(*shader);
+        RenderSprites();
+        RenderQuad(translationA, texture.get());
+        // Two stress textures a second, so the rest sit unused
+        const Texture* quadTexture = texture.get();
+        if (textureResidency && !loadedTextures.empty())
+            quadTexture = loadedTextures[static_cast<size_t>(lastFrameTime * 2.0) % loadedTextures.size()].get();
+        RenderQuad(translationB, quadTexture);
+        spriteBatch->End();
     }
 
     if (imguiInitialized)
     {
         RenderUI();
+        RenderProfilerUI();
 
         // Render ImGui UI
+        GPUProfileScope scope(gpuProfiler.get(), "ImGui pass");
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        // The ImGui backend binds its own objects; don't trust the cache afterwards
+        GLState::Invalidate();
     }
+
+    gpuProfiler->EndFrame();
+    renderer->EndFrame();
+}
+
+/**
+ * @brief Streams this frame's shared uniform blocks and binds the per-frame one.
+ *
+ * Both views are uploaded up front; switching between them is a single
+ * buffer range bind instead of re-setting uniforms on every shader.
+ */
+void OpenGLApp::UploadUniformBlocks()
+{
+    StreamBuffer& stream = renderer->GetStreamBuffer();
+
+    frameUniforms->Set("u_LightPos", glm::vec3(2.0f, 2.0f, 2.0f));
+    frameUniforms->Set("u_Time", static_cast<float>(lastFrameTime));
+    frameUniforms->Set("u_LightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+    frameUniforms->Upload(stream);
+    frameUniforms->Bind();
+
+    viewUniforms3D->Set("u_View", view3D);
+    viewUniforms3D->Set("u_Projection", projection3D);
+    viewUniforms3D->Set("u_ViewProjection", projection3D * view3D);
+    viewUniforms3D->Set("u_ViewPos", glm::vec3(3.0f, 3.0f, 3.0f)); // camera position used for view3D
+    viewUniforms3D->Upload(stream);
+
+    viewUniforms2D->Set("u_View", view);
+    viewUniforms2D->Set("u_Projection", projection);
+    viewUniforms2D->Set("u_ViewProjection", projection * view);
+    viewUniforms2D->Set("u_ViewPos", glm::vec3(0.0f));
+    viewUniforms2D->Upload(stream);
 }
 
 /**
- * @brief Renders a quad at the given translation.
+ * @brief Adds a quad at the given translation to the sprite batch.
  * @param translation The translation vector for the quad.
+ * @param quadTexture The texture to draw it with.
  */
-void OpenGLApp::RenderQuad(const glm::vec3& translation)
+void OpenGLApp::RenderQuad(const glm::vec3& translation, const Texture* quadTexture)
 {
-    if (!shader || !renderer || !va || !ib) return;
+    if (!spriteBatch) return;
 
-    glm::mat4 model = glm::translate(glm::mat4(1.0f), translation);
-    glm::mat4 mvp = projection * view * model;
-    shader->SetUniformMat4f("u_MVP", mvp);
+    const glm::vec4 rect(600.0f, QUAD_Y_POS, QUAD_SIZE, QUAD_HEIGHT);
+    const glm::vec4 color(colorValue, 1.0f, 1.0f, 1.0f);
+    if (quadTexture)
+        textureLoader->RequestFootprint(*quadTexture, std::max(QUAD_SIZE, QUAD_HEIGHT));
+    spriteBatch->Submit(rect, quadTexture, color, glm::translate(glm::mat4(1.0f), translation));
+}
 
-    renderer->Draw(*va, *ib, *shader);
+/**
+ * @brief Adds the moving stress-test sprites to the sprite batch.
+ */
+void OpenGLApp::RenderSprites()
+{
+    if (!spriteBatch) return;
+
+    const glm::vec2 size(24.0f, 24.0f);
+    const glm::vec4 color(1.0f, 1.0f, 1.0f, 1.0f);
+    if (!spriteAtlas || spriteAtlas->GetRegionCount() == 0)
+    {
+        if (texture && !sprites.empty())
+            textureLoader->RequestFootprint(*texture, size.x);
+        for (const MovingSprite& sprite : sprites)
+            spriteBatch->Submit(sprite.position, size, sprite.rotation, texture.get(), color);
+        return;
+    }
+    for (const MovingSprite& sprite : sprites)
+    {
+        const AtlasRegion& region = spriteAtlas->GetRegion(sprite.image);
+        spriteBatch->Submit(sprite.position, size, sprite.rotation, spriteAtlas->GetPage(region.page),
+                            color, region.uvRect);
+    }
 }
 
 /**
- * @brief Renders the rotating 3D cube.
+ * @brief Queues the rotating 3D cube.
  * 
  * Sets up model matrix with rotation, binds cube shader with
- * appropriate uniforms for lighting, and renders the cube.
+ * appropriate uniforms for lighting, and submits the cube. The
+ * per-draw matrices are uploaded by the renderer on Flush.
  */
 void OpenGLApp::RenderCube()
 {
     if (!cube || !cubeShader || !renderer) return;
     
-    cubeShader->Bind();
+    const Texture* cubeTexture = (cubeUseTexture && texture) ? texture.get() : nullptr;
+    
+    if (cubeInstanced && cubeInstances && cubeInstancedShader)
+    {
+        // Every instance in one draw; the model matrix is built in the vertex shader.
+        // With the texture array each instance picks its layer, same binding.
+        unsigned int variant = cubeTexture ? cubeInstancedUniforms.textureVariant : 0;
+        if (cubeTexture && cubeTextureArray && !cubeLayers.empty())
+        {
+            cubeTexture = cubeLayers[0].array;
+            variant = cubeInstancedUniforms.textureArrayVariant;
+        }
+        else if (cubeTexture)
+        {
+            textureLoader->RequestFootprint(*cubeTexture, cubeInstanceFootprint);
+        }
+        cubeInstancedShader->Bind(variant);
+        cubeInstancedShader->SetUniform3f(cubeInstancedUniforms.color, 0.8f, 0.6f, 0.2f);
+        cubeInstancedShader->SetUniform1i(cubeInstancedUniforms.texture, 0);
+        
+        if (cubeMixedMeshes && meshRegistry)
+        {
+            RenderMixedMeshes(cubeTexture);
+        }
+        else
+        {
+            cubeInstances->Update(cubeInstanceData.data(), static_cast<unsigned int>(cubeInstanceData.size()));
+            cubeInstances->Render(*renderer, *cubeInstancedShader, cubeTexture, variant);
+        }
+        return;
+    }
+    
+    // The textured variant samples u_Texture; the plain one only reads u_Color
+    const unsigned int variant = cubeTexture ? cubeUniforms.textureVariant : 0;
+    if (cubeTexture)
+    {
+        // A unit cube at the origin, so the camera's distance is the view-space translation
+        textureLoader->RequestFootprint(*cubeTexture, GetFootprint(1.0f, glm::length(glm::vec3(view3D[3]))));
+    }
+    cubeShader->Bind(variant);
     
     // Create model matrix with rotation
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::rotate(model, glm::radians(cubeRotationX), glm::vec3(1.0f, 0.0f, 0.0f));
     model = glm::rotate(model, glm::radians(cubeRotationY), glm::vec3(0.0f, 1.0f, 0.0f));
     
-    // Set shader uniforms
-    glm::mat4 mvp = projection3D * view3D * model;
-    cubeShader->SetUniformMat4f("u_MVP", mvp);
-    cubeShader->SetUniformMat4f("u_Model", model);
-    cubeShader->SetUniform3f("u_Color", 0.8f, 0.6f, 0.2f); // Orange-ish color
-    cubeShader->SetUniform3f("u_LightPos", 2.0f, 2.0f, 2.0f);
-    cubeShader->SetUniform3f("u_ViewPos", 3.0f, 3.0f, 3.0f);
-    cubeShader->SetUniformBool("u_UseTexture", cubeUseTexture);
+    // Set material uniforms; camera and light come from the shared blocks
+    cubeShader->SetUniform3f(cubeUniforms.color, 0.8f, 0.6f, 0.2f); // Orange-ish color
+    cubeShader->SetUniform1i(cubeUniforms.texture, 0);
     
-    // Bind texture if using texture mode
-    if (cubeUseTexture && texture) {
-        texture->Bind();
-        cubeShader->SetUniform1i("u_Texture", 0);
-    }
-    
-    cube->Render(*renderer, *cubeShader, model, view3D, projection3D);
+    cube->Render(*renderer, *cubeShader, model, view3D, projection3D, cubeTexture, variant);
+}
+
+/**
+ * @brief Draws the instance grid as half cubes, half pyramids in one multi-draw.
+ *
+ * Both meshes come from the mesh registry, so this is one VAO bind and,
+ * with indirect draws, a single draw call. Drawn immediately (not queued),
+ * with the instanced shader already bound by RenderCube.
+ *
+ * @param cubeTexture Optional texture for slot 0
+ */
+void OpenGLApp::RenderMixedMeshes(const Texture* cubeTexture)
+{
+    const unsigned int count = static_cast<unsigned int>(cubeInstanceData.size());
+    StreamAllocation instances = renderer->GetStreamBuffer().Upload(
+        cubeInstanceData.data(), count * static_cast<unsigned int>(sizeof(CubeInstance)));
+
+    MeshDrawCommand commands[2];
+    commands[0].mesh = cubeMesh;
+    commands[0].instanceCount = count - count / 2;
+    commands[1].mesh = pyramidMesh;
+    commands[1].instanceCount = count / 2;
+    commands[1].firstInstance = commands[0].instanceCount;
+
+    if (cubeTexture)
+        cubeTexture->Bind(0);
+    meshRegistry->Draw(commands, commands[1].instanceCount > 0 ? 2 : 1, instances);
+}
+
+/**
+ * @brief Approximate on-screen size of something in the 3D view.
+ *
+ * Used to ask streamed textures for the mip levels a draw actually needs.
+ *
+ * @param worldSize Its extent in world units
+ * @param distance Its depth in front of the camera
+ * @return Pixels across
+ */
+float OpenGLApp::GetFootprint(float worldSize, float distance) const
+{
+    return worldSize * projection3D[1][1] * 0.5f * static_cast<float>(WINDOW_HEIGHT) / distance;
 }
 
 /**
@@ -401,7 +953,7 @@ void OpenGLApp::RenderUI()
     if (!imguiInitialized) return;
 
     // Set fixed window size and position - increased width to prevent text cropping
-    ImGui::SetNextWindowSize(ImVec2(380, 520), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(380, 640), ImGuiCond_Always);
     ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
     
     ImGui::Begin("OpenGL Renderer Controls", nullptr, 
@@ -423,6 +975,18 @@ void OpenGLApp::RenderUI()
         ImGui::SeparatorText("2D Quad Settings");
         ImGui::SliderFloat2("Quad 1 Pos", &translationA.x, -800.0f, 800.0f);
         ImGui::SliderFloat2("Quad 2 Pos", &translationB.x, -800.0f, 800.0f);
+        ImGui::SliderInt("Sprites", &spriteCount, 0, MAX_STRESS_SPRITES, "%d",
+                         ImGuiSliderFlags_Logarithmic);
+        if (spriteBatch)
+        {
+            const SpriteBatchStats& batchStats = spriteBatch->GetStats();
+            ImGui::Text("Batched: %u quads in %u draws", batchStats.quads, batchStats.drawCalls);
+        }
+        if (spriteAtlas)
+        {
+            ImGui::Text("Sprite atlas: %u images on %u page(s)%s", spriteAtlas->GetRegionCount(),
+                        spriteAtlas->GetPageCount(), spriteAtlas->IsCached() ? ", cached" : "");
+        }
         ImGui::Spacing();
     }
     
@@ -432,6 +996,35 @@ void OpenGLApp::RenderUI()
         ImGui::SeparatorText("3D Cube Settings");
         ImGui::SliderFloat("Rotation Speed", &cubeRotationSpeed, 0.0f, 180.0f, "%.0f°/sec");
         ImGui::Checkbox("Use Texture", &cubeUseTexture);
+        if (cubeUseTexture && Texture::GetMaxAnisotropy() > 1.0f &&
+            ImGui::SliderFloat("Anisotropy", &textureAnisotropy, 1.0f, Texture::GetMaxAnisotropy(), "%.0fx"))
+        {
+            Texture::SetDefaultAnisotropy(textureAnisotropy);
+            if (texture)
+                texture->SetAnisotropy(textureAnisotropy);
+            for (const auto& loaded : loadedTextures)
+                loaded->SetAnisotropy(textureAnisotropy);
+        }
+        ImGui::Checkbox("Instanced", &cubeInstanced);
+        if (cubeInstanced)
+        {
+            ImGui::SliderInt("Instances", &cubeInstanceCount, 1, MAX_CUBE_INSTANCES, "%d",
+                             ImGuiSliderFlags_Logarithmic);
+            if (cubeUseTexture && !cubeLayers.empty())
+            {
+                ImGui::Checkbox("Texture Array", &cubeTextureArray);
+                const TextureArrayStats arrayStats = textureArrays->GetStats();
+                ImGui::SameLine();
+                ImGui::Text("(%u layers in %u arrays)", arrayStats.layersUsed, arrayStats.arrays);
+            }
+            ImGui::Checkbox("Mixed Meshes", &cubeMixedMeshes);
+            if (cubeMixedMeshes && meshRegistry)
+            {
+                const MeshDrawStats& meshStats = meshRegistry->GetStats();
+                ImGui::Text("%u commands in %u calls (%s)", meshStats.commands, meshStats.apiCalls,
+                            meshRegistry->IsIndirect() ? "indirect" : "base vertex");
+            }
+        }
         ImGui::Text("Rotation: X=%.0f° Y=%.0f°", cubeRotationX, cubeRotationY);
         ImGui::Spacing();
     }
@@ -440,6 +1033,55 @@ void OpenGLApp::RenderUI()
     ImGui::SeparatorText("Performance");
     ImGuiIO& io = ImGui::GetIO();
     ImGui::Text("FPS: %.1f (%.2fms/frame)", io.Framerate, 1000.0f / io.Framerate);
+    if (renderer)
+    {
+        const RenderStats& stats = renderer->GetStats();
+        ImGui::Text("Draw calls: %u", stats.drawCalls);
+        ImGui::Text("Changes: shader %u, VAO %u, texture %u",
+                    stats.shaderChanges, stats.vertexArrayChanges, stats.textureChanges);
+        ImGui::Text("Stream buffer: %s", renderer->GetStreamBuffer().IsPersistent() ? "persistent" : "orphaning");
+    }
+    const GLStateStats& bindStats = GLState::GetFrameStats();
+    ImGui::Text("GL binds: %u issued, %u skipped", bindStats.issued, bindStats.skipped);
+    ImGui::Text("Uniforms: %u set, %u skipped", bindStats.uniformsIssued, bindStats.uniformsSkipped);
+    const ShaderCacheStats& cacheStats = ShaderCache::GetStats();
+    ImGui::Text("Shaders: %u cached, %u compiled (%.1f ms)", cacheStats.hits, cacheStats.misses, cacheStats.milliseconds);
+    if (const AssetPack* pack = AssetPack::GetMounted())
+        ImGui::Text("Assets: %s, %u files (hot reload off)", options.assetPack.c_str(), pack->GetCount());
+    if (shaderReloader)
+    {
+        ImGui::Text("Hot reload: %s", shaderReloader->IsNative() ? "inotify" : "polling");
+        if (!shaderReloader->GetStatus().empty())
+            ImGui::TextWrapped("%s", shaderReloader->GetStatus().c_str());
+    }
+    if (textureLoader)
+    {
+        const TextureLoaderStats& loaderStats = textureLoader->GetStats();
+        ImGui::Text("Textures: %u loaded, %u pending (%.2f ms last frame)",
+                    loaderStats.loaded, textureLoader->GetPendingCount(), loaderStats.lastUpdateMs);
+        ImGui::Text("Mips: %u built (%s), %u from cache", loaderStats.mipsBuilt,
+                    MipGenerator::IsSimd() ? "SSE2" : "scalar", loaderStats.mipCacheHits);
+        ImGui::Text("BCn: %u compressed (%u from cache)%s", loaderStats.compressed,
+                    loaderStats.compressedCacheHits, textureLoader->IsCompressing() ? "" : ", off");
+        if (options.streamTextures)
+        {
+            ImGui::Text("Streaming: %u textures, %u levels added, %u still to come", loaderStats.streamed,
+                        loaderStats.levelsStreamed, textureLoader->GetStreamingCount());
+            if (texture)
+                ImGui::Text("Texture: levels %d-%d resident", texture->GetBaseLevel(), texture->GetLevelCount() - 1);
+        }
+    }
+    if (textureResidency)
+    {
+        const TextureResidencyStats& residencyStats = textureResidency->GetStats();
+        ImGui::Text("VRAM: %.1f of %.1f MB, %u shrunk, %u evicted", residencyStats.resident / 1048576.0,
+                    residencyStats.budget / 1048576.0, residencyStats.reduced, residencyStats.evicted);
+        ImGui::Text("Residency: %u reductions, %u evictions, %u restores", residencyStats.reductions,
+                    residencyStats.evictions, residencyStats.restores);
+        if (ImGui::SliderInt("Texture Budget", &textureBudgetMB, 1, 256, "%d MB"))
+            textureResidency->SetBudget(size_t(textureBudgetMB) << 20);
+    }
+    ImGui::Checkbox("GPU Profiler", &showProfiler);
     
     // Get OpenGL version and truncate if too long (safe C++ version)
     const char* glVersion = (const char*)glGetString(GL_VERSION);
@@ -466,6 +1108,156 @@ void OpenGLApp::RenderUI()
     ImGui::End();
 }
 
+/**
+ * @brief Renders the GPU profiler window: per-pass timings and rolling graphs.
+ */
+void OpenGLApp::RenderProfilerUI()
+{
+    if (!imguiInitialized || !showProfiler || !gpuProfiler) return;
+
+    ImGui::SetNextWindowSize(ImVec2(420, 420), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowPos(ImVec2(400, 10), ImGuiCond_FirstUseEver);
+    ImGui::Begin("GPU Profiler", &showProfiler);
+
+    gpuProfiler->OnImGuiRender();
+
+    ImGui::Spacing();
+    if (ImGui::Button("Export CSV"))
+    {
+        const char* path = "gpu_profile.csv";
+        profileExportStatus = gpuProfiler->WriteCSV(path) ? std::string("Wrote ") + path : "Export failed";
+    }
+    if (!profileExportStatus.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(profileExportStatus.c_str());
+    }
+
+    ImGui::End();
+}
+
+/**
+ * @brief Renders warm-up plus measured frames offscreen and reports frame times.
+ *
+ * Each frame ends with glFinish, so a frame time covers the CPU work and
+ * the GPU (or llvmpipe) work it queued, not just command submission.
+ *
+ * @return Process exit code
+ */
+int OpenGLApp::RunBenchmark()
+{
+    const int warmup = std::max(options.warmupFrames, 0);
+    const int frames = std::max(options.frames, 1);
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frames);
+    for (int i = 0; i < warmup + frames; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        Update();
+        Render();
+        GLCall(glFinish());
+        const auto end = std::chrono::steady_clock::now();
+
+        if (i >= warmup)
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    return WriteBenchmarkReport(frameTimes) ? 0 : 1;
+}
+
+// Escapes the characters JSON does not allow raw inside a string
+static std::string JsonEscape(const char* text)
+{
+    std::string result;
+    for (const char* c = text ? text : ""; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            result += '\\';
+        if (static_cast<unsigned char>(*c) < 0x20)
+            result += ' ';
+        else
+            result += *c;
+    }
+    return result;
+}
+
+/**
+ * @brief Writes frame-time statistics as JSON to options.output or stdout.
+ * @param frameTimes Milliseconds per measured frame
+ * @return true if the report was written
+ */
+bool OpenGLApp::WriteBenchmarkReport(const std::vector<double>& frameTimes) const
+{
+    std::vector<double> sorted(frameTimes);
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (double t : sorted)
+        total += t;
+
+    // Nearest-rank percentile
+    auto percentile = [&sorted](double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    };
+
+    std::ostringstream json;
+    json.setf(std::ios::fixed);
+    json.precision(4);
+    json << "{\n"
+         << "  \"context\": \"" << JsonEscape(contextDescription.c_str()) << "\",\n"
+         << "  \"renderer\": \"" << JsonEscape(reinterpret_cast<const char*>(glGetString(GL_RENDERER))) << "\",\n"
+         << "  \"version\": \"" << JsonEscape(reinterpret_cast<const char*>(glGetString(GL_VERSION))) << "\",\n"
+         << "  \"width\": " << WINDOW_WIDTH << ",\n"
+         << "  \"height\": " << WINDOW_HEIGHT << ",\n"
+         << "  \"warmup_frames\": " << std::max(options.warmupFrames, 0) << ",\n"
+         << "  \"frames\": " << sorted.size() << ",\n"
+         << "  \"scene\": { \"quads\": " << (showQuads ? "true" : "false")
+         << ", \"sprites\": " << (showQuads ? spriteCount : 0)
+         << ", \"cube\": " << (showCube ? "true" : "false")
+         << ", \"instances\": " << (showCube && cubeInstanced ? cubeInstanceCount : 0)
+         << ", \"mixed_meshes\": " << (showCube && cubeInstanced && cubeMixedMeshes ? "true" : "false")
+         << ", \"compressed_textures\": " << (textureLoader && textureLoader->IsCompressing() ? "true" : "false")
+         << ", \"texture_budget_mb\": " << (textureResidency ? textureBudgetMB : 0)
+         << ", \"streamed_textures\": " << (options.streamTextures ? "true" : "false")
+         << ", \"asset_pack\": " << (AssetPack::GetMounted() ? "true" : "false") << " },\n"
+         << "  \"frame_ms\": {\n"
+         << "    \"mean\": " << total / static_cast<double>(sorted.size()) << ",\n"
+         << "    \"p50\": " << percentile(50.0) << ",\n"
+         << "    \"p95\": " << percentile(95.0) << ",\n"
+         << "    \"p99\": " << percentile(99.0) << ",\n"
+         << "    \"max\": " << sorted.back() << "\n"
+         << "  }";
+
+    // Mean GPU time per pass over the profiler's history window
+    if (gpuProfiler && gpuProfiler->GetHistoryCount() > 0)
+    {
+        json << ",\n  \"gpu_ms\": {";
+        const std::vector<GPUScopeStats>& scopes = gpuProfiler->GetScopes();
+        for (size_t i = 0; i < scopes.size(); ++i)
+            json << (i ? ", " : " ") << "\"" << JsonEscape(scopes[i].name.c_str()) << "\": " << scopes[i].average;
+        json << " }";
+    }
+    json << "\n}\n";
+
+    if (options.output.empty())
+    {
+        std::cout << json.str() << std::flush;
+        return true;
+    }
+
+    std::ofstream file(options.output);
+    if (!file)
+    {
+        std::cerr << "Failed to write benchmark report to " << options.output << std::endl;
+        return false;
+    }
+    file << json.str();
+    return true;
+}
+
 /**
  * @brief Cleans up resources and shuts down ImGui and GLFW.
  */
@@ -481,16 +1273,35 @@ void OpenGLApp::Cleanup()
     }
 
     // Reset owned resources
-    renderer.reset();
-    va.reset();
-    vb.reset();
-    ib.reset();
+    shaderReloader.reset();
+    spriteBatch.reset();
+    sprites.clear();
+    spriteAtlas.reset();
+    cubeLayers.clear();
+    textureArrays.reset();
     shader.reset();
+    textureResidency.reset();
     texture.reset();
+    loadedTextures.clear();
+    textureLoader.reset();
+    // After the loader, whose threads read from it
+    AssetPack::Unmount();
     
-    // Reset 3D cube resources
+    // Reset 3D cube resources (instances share the cube's buffers)
+    meshRegistry.reset();
+    cubeInstances.reset();
+    cubeInstancedShader.reset();
     cube.reset();
     cubeShader.reset();
+
+    frameUniforms.reset();
+    viewUniforms3D.reset();
+    viewUniforms2D.reset();
+
+    // Last, since the batch and instances allocate from its stream buffer
+    gpuProfiler.reset();
+    renderer.reset();
+    offscreen.reset();
     
     sceneSetup = false;
 
@@ -505,6 +1316,8 @@ void OpenGLApp::Cleanup()
         glfwTerminate();
         glfwInitialized = false;
     }
+
+    headlessContext.reset();
 }
 
 #ifdef _MSC_VER
@@ -1,50 +1,174 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>  // Needed for glm::vec3 and glm::mat4
 
+#include "InstancedCube.h"
+#include "MeshRegistry.h"
+#include "Shader.h"
+#include "SpriteBatch.h"
+#include "TextureArrayManager.h"
+#include "TextureResidency.h"
+
 struct GLFWwindow;
 class Renderer;
-class VertexArray;
-class VertexBuffer;
-class IndexBuffer;
-class Shader;
 class Texture;
 class Cube;
+class UniformBuffer;
+class Framebuffer;
+class HeadlessContext;
+class GPUProfiler;
+class ShaderReloader;
+class TextureLoader;
+class TextureAtlas;
+
+/**
+ * @brief Command line options; see PrintUsage in main.cpp.
+ */
+struct AppOptions
+{
+    // Headless benchmark: no window, vsync off, renders offscreen for a
+    // fixed number of frames and prints frame-time statistics as JSON
+    bool headless = false;
+    int frames = 600;
+    int warmupFrames = 60;
+    std::string output;         // JSON report path, stdout if empty
+
+    // Scene selection, applied in both modes
+    int sprites = 0;
+    int instances = 0;          // > 0 shows the instanced cube grid
+    bool cube = false;
+    bool mixedMeshes = false;
+    bool noQuads = false;
+    int loadTextures = 0;       // textures streamed in after startup (loader stress test)
+    bool noCompression = false; // RGBA8 textures even where BCn is supported
+    int textureBudget = 0;      // MB; > 0 shrinks textures unused to stay within it
+    bool streamTextures = false; // coarse mips first, finer ones as their on-screen size asks
+    std::string assetPack;      // asset pack to mount (see AssetPack); empty reads the loose files
+};
 
 class OpenGLApp
 {
 public:
-    OpenGLApp();
+    explicit OpenGLApp(const AppOptions& options = AppOptions());
     ~OpenGLApp();
 
     bool Initialize();
-    void Run();
+    // Returns the process exit code
+    int Run();
 
 private:
     bool InitializeGLFW();
+    bool InitializeHeadless();
     bool InitializeOpenGL();
     bool InitializeImGui();
     bool SetupScene();
     void Update();
     void Render();
-    void RenderQuad(const glm::vec3& translation);
+    void RenderQuad(const glm::vec3& translation, const Texture* quadTexture);
+    void UpdateSprites();
+    void RenderSprites();
     void RenderCube();
+    void RenderMixedMeshes(const Texture* cubeTexture);
+    float GetFootprint(float worldSize, float distance) const;
+    void UploadUniformBlocks();
+    void UpdateCubeInstances();
+    void LayoutCubeInstances();
     void RenderUI();
+    void RenderProfilerUI();
+    int RunBenchmark();
+    bool WriteBenchmarkReport(const std::vector<double>& frameTimes) const;
     void Cleanup();
 
+    AppOptions options;
+    std::unique_ptr<HeadlessContext> headlessContext;
+    std::unique_ptr<Framebuffer> offscreen;
+    std::string contextDescription;
+
     GLFWwindow* window = nullptr;  // Pointer is fine
     std::unique_ptr<Renderer> renderer;
-    std::unique_ptr<VertexArray> va;
-    std::unique_ptr<VertexBuffer> vb;
-    std::unique_ptr<IndexBuffer> ib;
     std::unique_ptr<Shader> shader;
     std::unique_ptr<Texture> texture;
+    std::unique_ptr<SpriteBatch> spriteBatch;
+
+    // Shared uniform blocks: one per frame, one per view (3D scene, 2D overlay)
+    std::unique_ptr<UniformBuffer> frameUniforms;
+    std::unique_ptr<UniformBuffer> viewUniforms3D;
+    std::unique_ptr<UniformBuffer> viewUniforms2D;
+
+    // GPU pass timings, shown in their own window
+    std::unique_ptr<GPUProfiler> gpuProfiler;
+    bool showProfiler = false;
+    std::string profileExportStatus;
+
+    // Recompiles edited .shader files while running (not in headless mode)
+    std::unique_ptr<ShaderReloader> shaderReloader;
+
+    // Decodes images on worker threads and uploads a few per frame; the
+    // stress textures only exist to exercise it (--load-textures)
+    std::unique_ptr<TextureLoader> textureLoader;
+    std::vector<std::unique_ptr<Texture>> loadedTextures;
+    // With a texture budget (--texture-budget), the second quad pages
+    // through the stress textures and the residency manager shrinks the
+    // ones not on screen
+    std::unique_ptr<TextureResidency> textureResidency;
+    int textureBudgetMB = 0;
+    // Requested anisotropic filtering, clamped to what the driver offers
+    float textureAnisotropy = 8.0f;
+    
+    // Moving sprite stress test; the sprites cycle through the atlas images,
+    // so they still go out in one draw
+    struct MovingSprite
+    {
+        glm::vec2 position;
+        glm::vec2 velocity;
+        float rotation;
+        float spin;
+        unsigned int image;     // atlas region
+    };
+    std::vector<MovingSprite> sprites;
+    int spriteCount = 0;
+    std::unique_ptr<TextureAtlas> spriteAtlas;
     
     // 3D Cube resources
     std::unique_ptr<Cube> cube;
     std::unique_ptr<Shader> cubeShader;
 
+    // Material uniforms shared by both cube shaders, resolved once after
+    // loading, plus the bits of the USE_TEXTURE(_ARRAY) variants
+    struct CubeUniforms
+    {
+        UniformHandle color;
+        UniformHandle texture;
+        unsigned int textureVariant = 0;
+        unsigned int textureArrayVariant = 0;   // instanced shader only
+    };
+    CubeUniforms cubeUniforms;
+    CubeUniforms cubeInstancedUniforms;
+    
+    // Instanced cube stress test
+    std::unique_ptr<InstancedCube> cubeInstances;
+    std::unique_ptr<Shader> cubeInstancedShader;
+    std::vector<CubeInstance> cubeInstanceData;
+    float cubeInstanceFootprint = 0.0f;     // pixels across the nearest instance
+    bool cubeInstanced = false;
+    int cubeInstanceCount = 1000;
+
+    // Mixed-mesh variant of the stress test: cubes and pyramids share one
+    // VAO and go out as a single multi-draw
+    std::unique_ptr<MeshRegistry> meshRegistry;
+    MeshHandle cubeMesh;
+    MeshHandle pyramidMesh;
+    bool cubeMixedMeshes = false;
+
+    // Texture array variant: every instance samples its own layer, still
+    // with one binding and one draw
+    std::unique_ptr<TextureArrayManager> textureArrays;
+    std::vector<TextureLayer> cubeLayers;
+    bool cubeTextureArray = false;
+
     // Animation state
     float colorValue = 0.0f;
     // colorSpeed is units per second, colorDirection is �1
@@ -0,0 +1,456 @@
+#include "AssetPack.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+std::unique_ptr<AssetPack> AssetPack::s_Mounted;
+
+namespace {
+
+	struct PackHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t count;
+		std::uint32_t namesSize;
+	};
+	// Then count entries, sorted by name, the names, and the data
+
+	constexpr char PackMagic[4] = { 'O', 'G', 'T', 'P' };
+	// Bump when the layout changes
+	constexpr std::uint32_t PackVersion = 2;
+
+	enum Compression : std::uint32_t
+	{
+		Stored = 0,
+		Lz4 = 1,
+	};
+
+	// Written next to the sources by MipGenerator, TextureCompressor and
+	// TextureAtlas; the pack is built from the sources alone
+	constexpr const char* GeneratedExtensions[] = { ".mips", ".bcn", ".atlas", ".tmp" };
+
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	std::string NormalizeName(const std::string& name)
+	{
+		return std::filesystem::path(name).lexically_normal().generic_string();
+	}
+
+	// LZ4 block format: sequences of a token (literal count, match length
+	// - 4), the literals, and a 16-bit offset back to the match
+	constexpr size_t MinMatch = 4;
+	constexpr size_t LastLiterals = 5;		// every block ends with at least these as literals
+	constexpr size_t MatchStartLimit = 12;	// and no match starts closer to its end
+	constexpr unsigned int HashBits = 12;
+
+	std::uint32_t Read32(const char* source)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, source, sizeof(value));
+		return value;
+	}
+
+	void WriteLength(std::vector<char>& target, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			target.push_back(static_cast<char>(255));
+		target.push_back(static_cast<char>(length));
+	}
+
+	// Greedy, one candidate per hash; the packer runs at build time, so
+	// the ratio matters more than the speed
+	std::vector<char> Compress(const char* source, size_t size)
+	{
+		std::vector<char> target;
+		target.reserve(size);
+		std::vector<std::uint32_t> table(size_t(1) << HashBits, 0);
+		size_t anchor = 0;
+
+		auto emit = [&](size_t literalEnd, size_t matchLength, size_t offset) {
+			const size_t literals = literalEnd - anchor;
+			const size_t token = target.size();
+			target.push_back(0);
+			unsigned char value = static_cast<unsigned char>(std::min<size_t>(literals, 15) << 4);
+			if (literals >= 15)
+				WriteLength(target, literals - 15);
+			target.insert(target.end(), source + anchor, source + literalEnd);
+			if (matchLength > 0)
+			{
+				target.push_back(static_cast<char>(offset & 0xFF));
+				target.push_back(static_cast<char>(offset >> 8));
+				const size_t length = matchLength - MinMatch;
+				value |= static_cast<unsigned char>(std::min<size_t>(length, 15));
+				if (length >= 15)
+					WriteLength(target, length - 15);
+			}
+			target[token] = static_cast<char>(value);
+		};
+
+		for (size_t i = 0; i + MatchStartLimit <= size; )
+		{
+			const std::uint32_t sequence = Read32(source + i);
+			std::uint32_t& slot = table[(sequence * 2654435761u) >> (32 - HashBits)];
+			const size_t candidate = slot;
+			slot = static_cast<std::uint32_t>(i);
+			if (candidate >= i || i - candidate > 0xFFFF || Read32(source + candidate) != sequence)
+			{
+				i++;
+				continue;
+			}
+
+			size_t length = MinMatch;
+			while (i + length < size - LastLiterals && source[candidate + length] == source[i + length])
+				length++;
+			emit(i, length, i - candidate);
+			i += length;
+			anchor = i;
+		}
+		emit(size, 0, 0);
+		return target;
+	}
+
+	// False unless source decodes to exactly size bytes
+	bool Decompress(const char* source, size_t sourceSize, char* target, size_t size)
+	{
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(source);
+		const unsigned char* const end = in + sourceSize;
+		size_t out = 0;
+
+		auto readLength = [&in, end](size_t& length) {
+			unsigned char byte = 255;
+			while (byte == 255)
+			{
+				if (in == end)
+					return false;
+				byte = *in++;
+				length += byte;
+			}
+			return true;
+		};
+
+		while (in < end)
+		{
+			const unsigned char token = *in++;
+			size_t literals = token >> 4;
+			if ((literals == 15 && !readLength(literals)) ||
+				literals > size_t(end - in) || literals > size - out)
+			{
+				return false;
+			}
+			std::memcpy(target + out, in, literals);
+			in += literals;
+			out += literals;
+			// The last sequence has no match
+			if (in == end)
+				break;
+
+			if (end - in < 2)
+				return false;
+			const size_t offset = size_t(in[0]) | size_t(in[1]) << 8;
+			in += 2;
+			size_t length = token & 15;
+			if (length == 15 && !readLength(length))
+				return false;
+			length += MinMatch;
+			if (offset == 0 || offset > out || length > size - out)
+				return false;
+			// Byte by byte: the match may overlap what it writes
+			for (size_t i = 0; i < length; i++, out++)
+				target[out] = target[out - offset];
+		}
+		return out == size;
+	}
+
+}
+
+struct AssetPack::Entry
+{
+	std::uint64_t offset;			// from the start of the pack; a multiple of Alignment
+	std::uint64_t size;				// of the file
+	std::uint64_t storedSize;		// in the pack
+	std::uint32_t nameOffset;		// into the names
+	std::uint32_t nameLength;
+	std::uint32_t compression;
+	std::uint32_t padding;
+	std::int64_t writeTime;			// of the source when packed (file_time_type ticks)
+};
+
+AssetPack::AssetPack(const std::string& path)
+	: m_File(std::make_unique<MappedFile>(path)), m_Entries(nullptr), m_Count(0), m_Names(nullptr), m_Open(false)
+{
+	const char* data = m_File->GetData();
+	const size_t fileSize = m_File->GetSize();
+	if (fileSize < sizeof(PackHeader))
+		return;
+
+	PackHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	const size_t namesOffset = sizeof(PackHeader) + size_t(header.count) * sizeof(Entry);
+	if (std::memcmp(header.magic, PackMagic, sizeof(PackMagic)) != 0 || header.version != PackVersion ||
+		header.count > fileSize / sizeof(Entry) || namesOffset + header.namesSize > fileSize)
+	{
+		return;
+	}
+	const Entry* entries = reinterpret_cast<const Entry*>(data + sizeof(PackHeader));
+	const char* names = data + namesOffset;
+
+	// Everything Find relies on: names in range and ascending, data in the file
+	std::string_view previous;
+	for (std::uint32_t i = 0; i < header.count; i++)
+	{
+		const Entry& entry = entries[i];
+		if (entry.nameOffset > header.namesSize || entry.nameLength > header.namesSize - entry.nameOffset ||
+			entry.offset % Alignment != 0 || entry.offset > fileSize || entry.storedSize > fileSize - entry.offset ||
+			(entry.compression != Stored && entry.compression != Lz4) ||
+			(entry.compression == Stored && entry.storedSize != entry.size))
+		{
+			return;
+		}
+		const std::string_view name(names + entry.nameOffset, entry.nameLength);
+		if (i > 0 && !(previous < name))
+			return;
+		previous = name;
+	}
+
+	m_Entries = entries;
+	m_Count = header.count;
+	m_Names = names;
+	m_Open = true;
+}
+
+AssetPack::~AssetPack()
+{
+}
+
+const AssetPack::Entry* AssetPack::FindEntry(const std::string& name) const
+{
+	const std::string normalized = NormalizeName(name);
+	const std::string_view key(normalized);
+	const Entry* end = m_Entries + m_Count;
+	const Entry* entry = std::lower_bound(m_Entries, end, key, [this](const Entry& candidate, std::string_view value) {
+		return std::string_view(m_Names + candidate.nameOffset, candidate.nameLength) < value;
+	});
+	if (entry == end || std::string_view(m_Names + entry->nameOffset, entry->nameLength) != key)
+		return nullptr;
+	return entry;
+}
+
+AssetView AssetPack::Find(const std::string& name) const
+{
+	const Entry* entry = m_Open ? FindEntry(name) : nullptr;
+	if (!entry)
+		return AssetView();
+	const char* stored = m_File->GetData() + entry->offset;
+	if (entry->compression == Stored)
+		return { stored, static_cast<size_t>(entry->size) };
+
+	const unsigned int index = static_cast<unsigned int>(entry - m_Entries);
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto decompressed = m_Decompressed.find(index);
+	if (decompressed == m_Decompressed.end())
+	{
+		std::vector<char> bytes(static_cast<size_t>(entry->size));
+		if (!Decompress(stored, static_cast<size_t>(entry->storedSize), bytes.data(), bytes.size()))
+		{
+			std::cout << "Asset pack: " << name << " is corrupt" << std::endl;
+			return AssetView();
+		}
+		decompressed = m_Decompressed.emplace(index, std::move(bytes)).first;
+	}
+	// The vector's buffer stays put however the map grows
+	return { decompressed->second.data(), decompressed->second.size() };
+}
+
+bool AssetPack::GetStamp(const std::string& name, size_t& size, std::filesystem::file_time_type& writeTime) const
+{
+	const Entry* entry = m_Open ? FindEntry(name) : nullptr;
+	if (!entry)
+		return false;
+	size = static_cast<size_t>(entry->size);
+	writeTime = std::filesystem::file_time_type(std::filesystem::file_time_type::duration(entry->writeTime));
+	return true;
+}
+
+bool AssetPack::Write(const std::string& packPath, const std::string& root, bool compress)
+{
+	struct Source
+	{
+		std::string name;
+		std::vector<char> stored;
+		std::uint64_t size;
+		std::int64_t writeTime;
+		Compression compression;
+	};
+	std::vector<Source> sources;
+
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+		!error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+	{
+		if (!it->is_regular_file(error))
+			continue;
+		const std::string extension = it->path().extension().string();
+		if (std::find(std::begin(GeneratedExtensions), std::end(GeneratedExtensions), extension) != std::end(GeneratedExtensions))
+			continue;
+
+		Source source;
+		source.name = it->path().lexically_normal().generic_string();
+		MappedFile file(it->path().string());
+		if (!file.IsOpen())
+		{
+			std::cout << "Asset pack: failed to read " << source.name << std::endl;
+			return false;
+		}
+		source.size = file.GetSize();
+		source.writeTime = static_cast<std::int64_t>(it->last_write_time(error).time_since_epoch().count());
+		if (error)
+		{
+			std::cout << "Asset pack: failed to stat " << source.name << std::endl;
+			return false;
+		}
+		source.compression = Stored;
+		if (compress && file.GetSize() > 0)
+		{
+			std::vector<char> compressed = Compress(file.GetData(), file.GetSize());
+			if (compressed.size() <= file.GetSize() - file.GetSize() / MinimumSaving)
+			{
+				source.stored = std::move(compressed);
+				source.compression = Lz4;
+			}
+		}
+		if (source.compression == Stored)
+			source.stored.assign(file.GetData(), file.GetData() + file.GetSize());
+		sources.push_back(std::move(source));
+	}
+	if (error)
+	{
+		std::cout << "Asset pack: failed to list " << root << ": " << error.message() << std::endl;
+		return false;
+	}
+	std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.name < b.name; });
+
+	PackHeader header = {};
+	std::memcpy(header.magic, PackMagic, sizeof(PackMagic));
+	header.version = PackVersion;
+	header.count = static_cast<std::uint32_t>(sources.size());
+
+	std::vector<Entry> entries(sources.size());
+	std::string names;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		entries[i] = {};
+		entries[i].nameOffset = static_cast<std::uint32_t>(names.size());
+		entries[i].nameLength = static_cast<std::uint32_t>(sources[i].name.size());
+		names += sources[i].name;
+	}
+	header.namesSize = static_cast<std::uint32_t>(names.size());
+
+	size_t offset = AlignUp(sizeof(PackHeader) + entries.size() * sizeof(Entry) + names.size(), Alignment);
+	std::uint64_t totalSize = 0, totalStored = 0;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		entries[i].offset = offset;
+		entries[i].size = sources[i].size;
+		entries[i].storedSize = sources[i].stored.size();
+		entries[i].compression = sources[i].compression;
+		entries[i].writeTime = sources[i].writeTime;
+		offset = AlignUp(offset + sources[i].stored.size(), Alignment);
+		totalSize += sources[i].size;
+		totalStored += sources[i].stored.size();
+	}
+
+	// Write to a temporary and rename, so a running app never maps half a pack
+	const std::string temporary = packPath + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			std::cout << "Asset pack: failed to create " << temporary << std::endl;
+			return false;
+		}
+		const char zeros[Alignment] = {};
+		auto pad = [&file, &zeros]() {
+			const size_t position = static_cast<size_t>(file.tellp());
+			file.write(zeros, AlignUp(position, Alignment) - position);
+		};
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+		file.write(names.data(), names.size());
+		for (const Source& source : sources)
+		{
+			pad();
+			file.write(source.stored.data(), source.stored.size());
+		}
+
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			std::cout << "Asset pack: failed to write " << temporary << std::endl;
+			return false;
+		}
+	}
+	std::filesystem::rename(temporary, packPath, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		std::cout << "Asset pack: failed to replace " << packPath << std::endl;
+		return false;
+	}
+
+	std::cout << "Asset pack: " << sources.size() << " files, " << totalSize / 1024 << " KB ("
+		<< totalStored / 1024 << " KB stored) in " << packPath << std::endl;
+	return true;
+}
+
+bool AssetPack::Mount(const std::string& path)
+{
+	s_Mounted.reset();
+	auto pack = std::make_unique<AssetPack>(path);
+	if (!pack->IsOpen())
+		return false;
+	s_Mounted = std::move(pack);
+	return true;
+}
+
+void AssetPack::Unmount()
+{
+	s_Mounted.reset();
+}
+
+AssetView AssetPack::FindMounted(const std::string& name)
+{
+	return s_Mounted ? s_Mounted->Find(name) : AssetView();
+}
+
+bool AssetPack::GetSourceStamp(const std::string& path, std::uint64_t& size, std::int64_t& time)
+{
+	// The source's own stamp, as it was packed: repacking keeps the caches
+	// of unchanged files, and they match the loose file's
+	size_t packed = 0;
+	std::filesystem::file_time_type packedTime;
+	if (s_Mounted && s_Mounted->GetStamp(path, packed, packedTime))
+	{
+		size = packed;
+		time = static_cast<std::int64_t>(packedTime.time_since_epoch().count());
+		return true;
+	}
+
+	std::error_code error;
+	size = std::filesystem::file_size(path, error);
+	if (error)
+		return false;
+	time = static_cast<std::int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+	return !error;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class MappedFile;
+
+// An asset's bytes: inside the pack's mapping, or the pack's copy of a
+// compressed one. Valid while the pack is open
+struct AssetView
+{
+	const char* data = nullptr;
+	size_t size = 0;
+
+	inline explicit operator bool() const { return data != nullptr; }
+};
+
+// The files of a directory tree (res/) in one file, mapped once and read
+// by name without copying.
+//
+// A pack is a header, an index sorted by name, the names, then each file's
+// bytes at an Alignment boundary. Names are paths as the app opens them
+// ("res/shaders/Basic.shader"), relative to the directory the packer ran
+// in, with forward slashes. A file may be stored LZ4-compressed (block
+// format) where that saves enough to be worth it; those are decompressed
+// on first use and the copy kept, so only the first Find pays.
+//
+// One pack can be mounted for the process; the shader preprocessor and
+// the image loaders look there first and fall back to the loose files.
+// Mount before the first load and unmount after the last: Find may be
+// called from any thread, mounting may not.
+class AssetPack
+{
+public:
+	// Of each file's bytes in the pack (cache line; any pixel format fits)
+	static constexpr size_t Alignment = 64;
+	// Compressed files are kept only when that saves at least 1/MinimumSaving
+	static constexpr size_t MinimumSaving = 8;
+
+private:
+	struct Entry;
+
+	std::unique_ptr<MappedFile> m_File;
+	const Entry* m_Entries;
+	unsigned int m_Count;
+	const char* m_Names;
+	bool m_Open;
+
+	mutable std::mutex m_Mutex;
+	mutable std::unordered_map<unsigned int, std::vector<char>> m_Decompressed;
+
+	static std::unique_ptr<AssetPack> s_Mounted;
+
+	const Entry* FindEntry(const std::string& name) const;
+public:
+	explicit AssetPack(const std::string& path);
+	~AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	// False if the file is missing or not a valid pack
+	inline bool IsOpen() const { return m_Open; }
+	inline unsigned int GetCount() const { return m_Count; }
+
+	// Empty if the pack has no such file (or it doesn't decompress)
+	AssetView Find(const std::string& name) const;
+	// Uncompressed size and the source's write time when it was packed,
+	// without decompressing; false if not in the pack
+	bool GetStamp(const std::string& name, size_t& size, std::filesystem::file_time_type& writeTime) const;
+
+	// Packs every regular file under root into packPath, except the caches
+	// the loaders write next to their sources (.mips, .bcn, .atlas, .tmp).
+	// Names are the files' paths starting with root as given. Prints a
+	// summary, or what failed and returns false
+	static bool Write(const std::string& packPath, const std::string& root, bool compress);
+
+	// Replaces the process-wide pack; false (and none mounted) if it can't be opened
+	static bool Mount(const std::string& path);
+	static void Unmount();
+	inline static const AssetPack* GetMounted() { return s_Mounted.get(); }
+	// Find in the mounted pack; empty if none is
+	static AssetView FindMounted(const std::string& name);
+	// Size and write time of a source, from the mounted pack if it has it,
+	// else from the file: what caches built from sources are checked against
+	static bool GetSourceStamp(const std::string& path, std::uint64_t& size, std::int64_t& time);
+};
@@ -5,3 +5,10 @@ constexpr int WINDOW_HEIGHT = 900;
 constexpr float QUAD_SIZE = 400.0f;
 constexpr float QUAD_Y_POS = 250.0f;
 constexpr float QUAD_HEIGHT = 400.0f;
+
+constexpr int MAX_CUBE_INSTANCES = 250000;
+constexpr int MAX_STRESS_SPRITES = 200000;
+
+// Bytes of per-frame streamed data (sprite vertices, instance data); the
+// stream buffer allocates this once per frame in flight
+constexpr unsigned int STREAM_BUFFER_FRAME_SIZE = 32 * 1024 * 1024;
@@ -22,33 +22,47 @@ Cube::Cube(float size) {
 }
 
 /**
- * @brief Renders the cube using the provided rendering components.
+ * @brief Submits the cube to the renderer's draw queue.
  * 
- * Binds necessary uniforms to the shader and issues the draw call.
- * The shader is expected to have u_MVP uniform for the combined
- * model-view-projection matrix.
+ * Builds a draw packet carrying the MVP and model matrices; the renderer
+ * uploads them as u_MVP and u_Model (if the shader declares them) when the
+ * queue is flushed. The packet depth is taken from the cube's center so the
+ * queue can order cubes front-to-back.
  * 
  * @param renderer The renderer instance
  * @param shader The shader program to use
  * @param model Model transformation matrix
  * @param view View transformation matrix  
  * @param projection Projection transformation matrix
+ * @param texture Optional texture for slot 0
+ * @param shaderVariant Keyword bits of the shader variant
  */
-void Cube::Render(const Renderer& renderer, const Shader& shader,
+void Cube::Render(Renderer& renderer, const Shader& shader,
                   const glm::mat4& model, const glm::mat4& view, 
-                  const glm::mat4& projection) const {
+                  const glm::mat4& projection, const Texture* texture,
+                  unsigned int shaderVariant) const {
     if (!m_vertexArray || !m_indexBuffer) {
         return; // Safety check
     }
     
-    // Calculate MVP matrix
-    glm::mat4 mvp = projection * view * model;
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.shaderVariant = shaderVariant;
+    packet.vertexArray = m_vertexArray.get();
+    packet.indexBuffer = m_indexBuffer.get();
+    if (texture) {
+        packet.textures[0] = texture;
+        packet.textureCount = 1;
+    }
+    packet.blend = BlendMode::Opaque;
+    packet.model = model;
+    packet.mvp = projection * view * model;
     
-    // Set shader uniforms
-    shader.SetUniformMat4f("u_MVP", mvp);
+    // Depth of the cube center in [0, 1]
+    glm::vec4 clip = packet.mvp * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    packet.depth = clip.w > 0.0f ? (clip.z / clip.w) * 0.5f + 0.5f : 0.0f;
     
-    // Render the cube
-    renderer.Draw(*m_vertexArray, *m_indexBuffer, shader);
+    renderer.Submit(packet);
 }
 
 /**
@@ -67,6 +81,26 @@ const IndexBuffer& Cube::GetIndexBuffer() const {
     return *m_indexBuffer;
 }
 
+/**
+ * @brief Gets the vertex buffer for external access.
+ * @return Reference to the vertex buffer object
+ */
+const VertexBuffer& Cube::GetVertexBuffer() const {
+    return *m_vertexBuffer;
+}
+
+/**
+ * @brief Builds the vertex layout shared by every cube VAO.
+ * @return Layout with position, normal and texture coordinate attributes
+ */
+VertexBufferLayout Cube::GetVertexLayout() {
+    VertexBufferLayout layout;
+    layout.Push<float>(3); // Position (x, y, z)
+    layout.Push<float>(3); // Normal (nx, ny, nz)
+    layout.Push<float>(2); // Texture coordinates (u, v)
+    return layout;
+}
+
 /**
  * @brief Generates cube vertex and index data.
  * 
@@ -160,14 +194,8 @@ void Cube::SetupBuffers() {
     m_vertexBuffer = std::make_unique<VertexBuffer>(
         m_vertices, VERTICES_COUNT * 8 * sizeof(float));
     
-    // Set up vertex buffer layout
-    VertexBufferLayout layout;
-    layout.Push<float>(3); // Position (x, y, z)
-    layout.Push<float>(3); // Normal (nx, ny, nz)
-    layout.Push<float>(2); // Texture coordinates (u, v)
-    
     // Add buffer to vertex array with layout
-    m_vertexArray->AddBuffer(*m_vertexBuffer, layout);
+    m_vertexArray->AddBuffer(*m_vertexBuffer, GetVertexLayout());
     
     // Create index buffer
     m_indexBuffer = std::make_unique<IndexBuffer>(m_indices, INDICES_COUNT);
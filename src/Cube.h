@@ -5,9 +5,11 @@
 
 class VertexArray;
 class VertexBuffer;
+class VertexBufferLayout;
 class IndexBuffer;
 class Shader;
 class Renderer;
+class Texture;
 
 /**
  * @brief A 3D cube primitive with RAII resource management.
@@ -36,16 +38,19 @@ public:
     Cube& operator=(Cube&&) = default;
     
     /**
-     * @brief Renders the cube with the given transformation matrices.
-     * @param renderer The renderer to use for drawing
+     * @brief Submits the cube to the renderer's queue with the given transformation matrices.
+     * @param renderer The renderer to submit to; the draw happens on Renderer::Flush
      * @param shader The shader to use for rendering
      * @param model The model transformation matrix
      * @param view The view matrix
      * @param projection The projection matrix
+     * @param texture Optional texture bound to slot 0
+     * @param shaderVariant Keyword bits of the shader variant to draw with
      */
-    void Render(const Renderer& renderer, const Shader& shader,
+    void Render(Renderer& renderer, const Shader& shader,
                 const glm::mat4& model, const glm::mat4& view, 
-                const glm::mat4& projection) const;
+                const glm::mat4& projection, const Texture* texture = nullptr,
+                unsigned int shaderVariant = 0) const;
     
     /**
      * @brief Gets the vertex array object for direct access if needed.
@@ -58,6 +63,26 @@ public:
      * @return Reference to the index buffer
      */
     const IndexBuffer& GetIndexBuffer() const;
+    
+    /**
+     * @brief Gets the vertex buffer, e.g. to share the geometry with another VAO.
+     * @return Reference to the vertex buffer
+     */
+    const VertexBuffer& GetVertexBuffer() const;
+    
+    /**
+     * @brief Gets the per-vertex layout: position(3), normal(3), texCoord(2).
+     * @return The vertex layout matching GetVertexBuffer()
+     */
+    static VertexBufferLayout GetVertexLayout();
+
+    /**
+     * @brief Gets the CPU copy of the geometry, e.g. to add it to a MeshRegistry.
+     */
+    inline const float* GetVertexData() const { return m_vertices; }
+    inline const unsigned int* GetIndexData() const { return m_indices; }
+    static constexpr unsigned int GetVertexCount() { return VERTICES_COUNT; }
+    static constexpr unsigned int GetIndexCount() { return INDICES_COUNT; }
 
 private:
     void GenerateGeometry(float size);
@@ -0,0 +1,138 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+static double NowSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string NormalizePath(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+FileWatcher::FileWatcher()
+	: m_Inotify(-1), m_NextScan(0.0)
+{
+#ifdef __linux__
+	m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Inotify < 0)
+		std::cout << "Warning: inotify unavailable, polling for file changes" << std::endl;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	if (m_Inotify >= 0)
+		close(m_Inotify);
+#endif
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	const std::string path = NormalizePath(directory.empty() ? "." : directory);
+	for (const Directory& watched : m_Directories)
+	{
+		if (watched.path == path)
+			return true;
+	}
+
+	Directory watched;
+	watched.path = path;
+#ifdef __linux__
+	if (m_Inotify >= 0)
+	{
+		// Editors either rewrite the file in place or rename a new one over it
+		watched.watch = inotify_add_watch(m_Inotify, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watched.watch < 0)
+		{
+			std::cout << "Warning: cannot watch " << path << std::endl;
+			return false;
+		}
+	}
+#endif
+	if (!IsNative())
+	{
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(path, error))
+			watched.writeTimes[entry.path().generic_string()] = entry.last_write_time(error);
+		if (error)
+		{
+			std::cout << "Warning: cannot watch " << path << std::endl;
+			return false;
+		}
+	}
+
+	m_Directories.push_back(watched);
+	return true;
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+	const size_t first = changed.size();
+
+#ifdef __linux__
+	if (m_Inotify >= 0)
+	{
+		alignas(inotify_event) char buffer[4096];
+		for (;;)
+		{
+			const ssize_t length = read(m_Inotify, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;	// EAGAIN: nothing more queued
+
+			for (ssize_t offset = 0; offset < length; )
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->len == 0)
+					continue;
+
+				for (const Directory& watched : m_Directories)
+				{
+					if (watched.watch == event->wd)
+						changed.push_back(watched.path + "/" + event->name);
+				}
+			}
+		}
+	}
+#endif
+
+	if (!IsNative())
+	{
+		const double now = NowSeconds();
+		if (now < m_NextScan)
+			return;
+		m_NextScan = now + ScanInterval;
+
+		for (Directory& watched : m_Directories)
+		{
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(watched.path, error))
+			{
+				const auto writeTime = entry.last_write_time(error);
+				if (error)
+					continue;
+				auto known = watched.writeTimes.find(entry.path().generic_string());
+				if (known == watched.writeTimes.end() || known->second != writeTime)
+				{
+					watched.writeTimes[entry.path().generic_string()] = writeTime;
+					changed.push_back(entry.path().generic_string());
+				}
+			}
+		}
+	}
+
+	// One save can produce several events
+	std::sort(changed.begin() + first, changed.end());
+	changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written in a set of watched directories (not recursive).
+// On Linux this is inotify, read without blocking; elsewhere the directory
+// listings are compared by modification time, at most every ScanInterval
+// seconds.
+class FileWatcher
+{
+public:
+	static constexpr double ScanInterval = 0.5;
+
+private:
+	struct Directory
+	{
+		std::string path;
+		int watch = -1;		// inotify watch descriptor
+		std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;	// polling fallback
+	};
+
+	std::vector<Directory> m_Directories;
+	int m_Inotify;
+	double m_NextScan;
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Watching the same directory twice is harmless
+	bool Watch(const std::string& directory);
+
+	// Appends the paths ("directory/name") of files written since the last
+	// call, each once
+	void Poll(std::vector<std::string>& changed);
+
+	// inotify rather than polling
+	inline bool IsNative() const { return m_Inotify >= 0; }
+};
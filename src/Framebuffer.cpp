@@ -0,0 +1,50 @@
+#include "Framebuffer.h"
+
+#include "Renderer.h"
+#include "GLState.h"
+
+#include <stdexcept>
+#include <string>
+
+Framebuffer::Framebuffer(int width, int height)
+	: m_RendererID(0), m_ColorAttachment(0), m_DepthAttachment(0), m_Width(width), m_Height(height)
+{
+	GLCall(glGenFramebuffers(1, &m_RendererID));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+
+	GLCall(glGenTextures(1, &m_ColorAttachment));
+	GLState::BindTexture(GL_TEXTURE_2D, m_ColorAttachment);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorAttachment, 0));
+
+	GLCall(glGenRenderbuffers(1, &m_DepthAttachment));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthAttachment));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthAttachment));
+
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("Framebuffer is incomplete (status " + std::to_string(status) + ")");
+}
+
+Framebuffer::~Framebuffer()
+{
+	GLCall(glDeleteFramebuffers(1, &m_RendererID));
+	GLCall(glDeleteTextures(1, &m_ColorAttachment));
+	GLState::OnTextureDeleted(m_ColorAttachment);
+	GLCall(glDeleteRenderbuffers(1, &m_DepthAttachment));
+}
+
+void Framebuffer::Bind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glViewport(0, 0, m_Width, m_Height));
+}
+
+void Framebuffer::Unbind() const
+{
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Offscreen render target: an RGBA8 color texture plus a 24-bit depth /
+// 8-bit stencil renderbuffer. Used for headless rendering, where there is
+// no default framebuffer to draw into.
+class Framebuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_ColorAttachment;
+	unsigned int m_DepthAttachment;
+	int m_Width, m_Height;
+public:
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// Binds for drawing and sets the viewport to the framebuffer size
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetColorAttachment() const { return m_ColorAttachment; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
@@ -0,0 +1,109 @@
+#include "GLDebug.h"
+
+#include "Renderer.h"
+
+#include <iostream>
+
+#if GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE
+GLCallRecord GLDebug::s_History[GL_DEBUG_CALL_HISTORY];
+unsigned int GLDebug::s_HistoryNext = 0;
+#endif
+
+static bool s_DebugOutput = false;
+
+static const char* SourceName(GLenum source)
+{
+	switch (source)
+	{
+		case GL_DEBUG_SOURCE_API:				return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM:		return "window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER:	return "shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY:		return "third party";
+		case GL_DEBUG_SOURCE_APPLICATION:		return "application";
+	}
+	return "other";
+}
+
+static const char* TypeName(GLenum type)
+{
+	switch (type)
+	{
+		case GL_DEBUG_TYPE_ERROR:				return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:	return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:	return "undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY:			return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE:			return "performance";
+		case GL_DEBUG_TYPE_MARKER:				return "marker";
+	}
+	return "other";
+}
+
+static const char* SeverityName(GLenum severity)
+{
+	switch (severity)
+	{
+		case GL_DEBUG_SEVERITY_HIGH:			return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM:			return "medium";
+		case GL_DEBUG_SEVERITY_LOW:				return "low";
+		case GL_DEBUG_SEVERITY_NOTIFICATION:	return "notification";
+	}
+	return "unknown";
+}
+
+static void GLAPIENTRY DebugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+	GLsizei length, const GLchar* message, const void* userParam)
+{
+	(void)length;
+	(void)userParam;
+
+	std::cout << "[OpenGL Debug] (" << SourceName(source) << ", " << TypeName(type) << ", "
+		<< SeverityName(severity) << ", " << id << ") " << message << std::endl;
+
+	if (type == GL_DEBUG_TYPE_ERROR)
+		GLDebug::DumpCallHistory(std::cout);
+}
+
+bool GLDebug::EnableDebugOutput(bool synchronous)
+{
+	if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
+		return false;
+
+	// Without a debug context (GLFW_OPENGL_DEBUG_CONTEXT) drivers may report
+	// nothing or only a subset, but enabling output is still valid
+	GLCall(glEnable(GL_DEBUG_OUTPUT));
+	if (synchronous)
+	{
+		GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+	}
+	else
+	{
+		GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+	}
+	GLCall(glDebugMessageCallback(DebugMessageCallback, nullptr));
+
+	// Notifications (buffer placement hints and the like) are too chatty to print every frame
+	GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE));
+
+	s_DebugOutput = true;
+	return true;
+}
+
+bool GLDebug::IsDebugOutputEnabled()
+{
+	return s_DebugOutput;
+}
+
+void GLDebug::DumpCallHistory(std::ostream& out)
+{
+#if GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE
+	const unsigned int count = s_HistoryNext < GL_DEBUG_CALL_HISTORY ? s_HistoryNext : GL_DEBUG_CALL_HISTORY;
+	out << "Last " << count << " GL calls (oldest first):" << std::endl;
+	for (unsigned int i = s_HistoryNext - count; i != s_HistoryNext; i++)
+	{
+		const GLCallRecord& record = s_History[i % GL_DEBUG_CALL_HISTORY];
+		out << "  " << record.file << ":" << record.line << "  " << record.call << std::endl;
+	}
+#else
+	(void)out;
+#endif
+}
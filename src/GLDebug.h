@@ -0,0 +1,71 @@
+#pragma once
+
+#include <ostream>
+
+// How much checking GLCall does, fixed at compile time:
+//
+//	GL_DEBUG_LEVEL_OFF		GLCall(x) is just x. No glGetError round trips.
+//	GL_DEBUG_LEVEL_ERRORS	glGetError is drained before and checked after each call.
+//	GL_DEBUG_LEVEL_TRACE	as ERRORS, and every call is recorded in a ring of the
+//							last GL_DEBUG_CALL_HISTORY calls, dumped when an error hits.
+//
+// Defaults to ERRORS in debug builds and OFF when NDEBUG is defined; define
+// GL_DEBUG_LEVEL (CMake: -DGL_DEBUG_LEVEL=N) to override. Release builds can
+// still get driver diagnostics through the KHR_debug callback, which costs
+// nothing on calls that don't produce a message.
+#define GL_DEBUG_LEVEL_OFF 0
+#define GL_DEBUG_LEVEL_ERRORS 1
+#define GL_DEBUG_LEVEL_TRACE 2
+
+#ifndef GL_DEBUG_LEVEL
+	#ifdef NDEBUG
+		#define GL_DEBUG_LEVEL GL_DEBUG_LEVEL_OFF
+	#else
+		#define GL_DEBUG_LEVEL GL_DEBUG_LEVEL_ERRORS
+	#endif
+#endif
+
+// Keep it a power of two so the wrapping ring index stays contiguous
+#ifndef GL_DEBUG_CALL_HISTORY
+	#define GL_DEBUG_CALL_HISTORY 256
+#endif
+
+struct GLCallRecord
+{
+	const char* call;	// stringized call, points into the binary's string table
+	const char* file;
+	int line;
+};
+
+class GLDebug
+{
+public:
+	// Installs the KHR_debug message callback if the context supports it.
+	// Synchronous mode reports each message from inside the offending call,
+	// so a breakpoint in the callback shows the culprit on the stack; it
+	// serializes the driver and is meant for debugging sessions only.
+	// Returns false if KHR_debug is not available.
+	static bool EnableDebugOutput(bool synchronous);
+	static bool IsDebugOutputEnabled();
+
+	// Call history (GL_DEBUG_LEVEL_TRACE only; a no-op otherwise)
+	static inline void RecordCall(const char* call, const char* file, int line)
+	{
+#if GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE
+		GLCallRecord& record = s_History[s_HistoryNext++ % GL_DEBUG_CALL_HISTORY];
+		record.call = call;
+		record.file = file;
+		record.line = line;
+#else
+		(void)call; (void)file; (void)line;
+#endif
+	}
+	// Writes the recorded calls, oldest first
+	static void DumpCallHistory(std::ostream& out);
+
+private:
+#if GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE
+	static GLCallRecord s_History[GL_DEBUG_CALL_HISTORY];
+	static unsigned int s_HistoryNext;
+#endif
+};
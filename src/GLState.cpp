@@ -0,0 +1,267 @@
+#include "GLState.h"
+
+#include "Renderer.h"
+
+#include <unordered_map>
+
+static constexpr unsigned int UNKNOWN = ~0u;
+
+static constexpr unsigned int BUFFER_TARGETS[] = {
+	GL_ARRAY_BUFFER,
+	GL_UNIFORM_BUFFER,
+	GL_PIXEL_PACK_BUFFER,
+	GL_PIXEL_UNPACK_BUFFER,
+	GL_COPY_READ_BUFFER,
+	GL_COPY_WRITE_BUFFER,
+	GL_DRAW_INDIRECT_BUFFER
+};
+static constexpr unsigned int BUFFER_TARGET_COUNT = sizeof(BUFFER_TARGETS) / sizeof(BUFFER_TARGETS[0]);
+
+static constexpr unsigned int TEXTURE_TARGETS[] = {
+	GL_TEXTURE_2D,
+	GL_TEXTURE_2D_ARRAY,
+	GL_TEXTURE_CUBE_MAP
+};
+static constexpr unsigned int TEXTURE_TARGET_COUNT = sizeof(TEXTURE_TARGETS) / sizeof(TEXTURE_TARGETS[0]);
+
+static unsigned int s_Program = UNKNOWN;
+static unsigned int s_VertexArray = UNKNOWN;
+// GL_ELEMENT_ARRAY_BUFFER is part of the VAO, so it is remembered per VAO
+static unsigned int s_ElementBuffer = UNKNOWN;
+static std::unordered_map<unsigned int, unsigned int> s_VertexArrayElementBuffers;
+static unsigned int s_Buffers[BUFFER_TARGET_COUNT];
+
+struct BufferRange
+{
+	unsigned int buffer;
+	unsigned int offset;
+	unsigned int size;
+};
+static BufferRange s_UniformRanges[GLState::MaxUniformBindings];
+static unsigned int s_ActiveUnit = UNKNOWN;
+static unsigned int s_Textures[GLState::MaxTextureUnits][TEXTURE_TARGET_COUNT];
+static bool s_Initialized = false;
+
+static GLStateStats s_Current;
+static GLStateStats s_LastFrame;
+
+static void EnsureInitialized()
+{
+	if (!s_Initialized)
+		GLState::Invalidate();
+}
+
+static int BufferTargetIndex(unsigned int target)
+{
+	for (unsigned int i = 0; i < BUFFER_TARGET_COUNT; i++)
+		if (BUFFER_TARGETS[i] == target)
+			return static_cast<int>(i);
+	return -1;
+}
+
+static int TextureTargetIndex(unsigned int target)
+{
+	for (unsigned int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+		if (TEXTURE_TARGETS[i] == target)
+			return static_cast<int>(i);
+	return -1;
+}
+
+// Returns true if the bind must be issued, updating the cached value and counters
+static inline bool Update(unsigned int& cached, unsigned int value)
+{
+	if (cached == value)
+	{
+		s_Current.skipped++;
+		return false;
+	}
+	cached = value;
+	s_Current.issued++;
+	return true;
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+	EnsureInitialized();
+	if (Update(s_Program, program))
+	{
+		GLCall(glUseProgram(program));
+	}
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray)
+{
+	EnsureInitialized();
+	if (!Update(s_VertexArray, vertexArray))
+		return;
+
+	GLCall(glBindVertexArray(vertexArray));
+	auto it = s_VertexArrayElementBuffers.find(vertexArray);
+	s_ElementBuffer = it != s_VertexArrayElementBuffers.end() ? it->second : UNKNOWN;
+}
+
+void GLState::BindBuffer(unsigned int target, unsigned int buffer)
+{
+	EnsureInitialized();
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		if (Update(s_ElementBuffer, buffer))
+		{
+			GLCall(glBindBuffer(target, buffer));
+			if (s_VertexArray != UNKNOWN)
+				s_VertexArrayElementBuffers[s_VertexArray] = buffer;
+		}
+		return;
+	}
+
+	int index = BufferTargetIndex(target);
+	if (index < 0)
+	{
+		s_Current.issued++;
+		GLCall(glBindBuffer(target, buffer));
+		return;
+	}
+	if (Update(s_Buffers[index], buffer))
+	{
+		GLCall(glBindBuffer(target, buffer));
+	}
+}
+
+void GLState::BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, unsigned int offset, unsigned int size)
+{
+	EnsureInitialized();
+	const int targetIndex = BufferTargetIndex(target);
+	if (target == GL_UNIFORM_BUFFER && index < MaxUniformBindings)
+	{
+		BufferRange& range = s_UniformRanges[index];
+		if (range.buffer == buffer && range.offset == offset && range.size == size)
+		{
+			s_Current.skipped++;
+			return;
+		}
+		range = { buffer, offset, size };
+	}
+
+	s_Current.issued++;
+	GLCall(glBindBufferRange(target, index, buffer, offset, size));
+	if (targetIndex >= 0)
+		s_Buffers[targetIndex] = buffer;
+}
+
+void GLState::BindTexture(unsigned int slot, unsigned int target, unsigned int texture)
+{
+	EnsureInitialized();
+	int index = TextureTargetIndex(target);
+	if (slot >= MaxTextureUnits || index < 0)
+	{
+		s_Current.issued += 2;
+		s_ActiveUnit = slot;
+		GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+		GLCall(glBindTexture(target, texture));
+		return;
+	}
+
+	if (s_Textures[slot][index] == texture)
+	{
+		s_Current.skipped++;
+		return;
+	}
+	if (Update(s_ActiveUnit, slot))
+	{
+		GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+	}
+	s_Textures[slot][index] = texture;
+	s_Current.issued++;
+	GLCall(glBindTexture(target, texture));
+}
+
+void GLState::BindTexture(unsigned int target, unsigned int texture)
+{
+	EnsureInitialized();
+	if (s_ActiveUnit == UNKNOWN)
+	{
+		BindTexture(0, target, texture);
+		return;
+	}
+	BindTexture(s_ActiveUnit, target, texture);
+}
+
+void GLState::OnProgramDeleted(unsigned int program)
+{
+	// A deleted program stays in use until another one is bound, but its
+	// name may be handed out again, so stop trusting the cache
+	if (s_Program == program)
+		s_Program = UNKNOWN;
+}
+
+void GLState::OnVertexArrayDeleted(unsigned int vertexArray)
+{
+	s_VertexArrayElementBuffers.erase(vertexArray);
+	if (s_VertexArray == vertexArray)
+	{
+		// Deleting the bound VAO reverts the binding to zero
+		s_VertexArray = 0;
+		auto it = s_VertexArrayElementBuffers.find(0);
+		s_ElementBuffer = it != s_VertexArrayElementBuffers.end() ? it->second : UNKNOWN;
+	}
+}
+
+void GLState::OnBufferDeleted(unsigned int buffer)
+{
+	// Deleting a buffer unbinds it from the context's binding points
+	if (s_ElementBuffer == buffer)
+		s_ElementBuffer = UNKNOWN;
+	for (auto& entry : s_VertexArrayElementBuffers)
+		if (entry.second == buffer)
+			entry.second = UNKNOWN;
+	for (unsigned int i = 0; i < BUFFER_TARGET_COUNT; i++)
+		if (s_Buffers[i] == buffer)
+			s_Buffers[i] = 0;
+	for (unsigned int i = 0; i < MaxUniformBindings; i++)
+		if (s_UniformRanges[i].buffer == buffer)
+			s_UniformRanges[i] = { 0, 0, 0 };
+}
+
+void GLState::OnTextureDeleted(unsigned int texture)
+{
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+		for (unsigned int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+			if (s_Textures[unit][i] == texture)
+				s_Textures[unit][i] = 0;
+}
+
+void GLState::Invalidate()
+{
+	s_Program = UNKNOWN;
+	s_VertexArray = UNKNOWN;
+	s_ElementBuffer = UNKNOWN;
+	s_VertexArrayElementBuffers.clear();
+	for (unsigned int i = 0; i < BUFFER_TARGET_COUNT; i++)
+		s_Buffers[i] = UNKNOWN;
+	for (unsigned int i = 0; i < MaxUniformBindings; i++)
+		s_UniformRanges[i] = { UNKNOWN, 0, 0 };
+	s_ActiveUnit = UNKNOWN;
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+		for (unsigned int i = 0; i < TEXTURE_TARGET_COUNT; i++)
+			s_Textures[unit][i] = UNKNOWN;
+	s_Initialized = true;
+}
+
+void GLState::CountUniform(bool issued)
+{
+	if (issued)
+		s_Current.uniformsIssued++;
+	else
+		s_Current.uniformsSkipped++;
+}
+
+void GLState::BeginFrame()
+{
+	s_LastFrame = s_Current;
+	s_Current = GLStateStats();
+}
+
+const GLStateStats& GLState::GetFrameStats()
+{
+	return s_LastFrame;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+struct GLStateStats
+{
+	unsigned int issued = 0;	// binds that reached the driver
+	unsigned int skipped = 0;	// binds dropped because nothing would change
+	unsigned int uniformsIssued = 0;	// glUniform* calls that reached the driver
+	unsigned int uniformsSkipped = 0;	// dropped because the program already had the value
+};
+
+// Shadow copy of the GL binding state. The wrapper classes (Shader,
+// VertexArray, VertexBuffer, IndexBuffer, Texture) bind through here, so a
+// bind that would not change anything never reaches the driver.
+//
+// The cache assumes it sees every bind. Code that changes bindings behind
+// its back (e.g. a third-party backend that does not restore them) must be
+// followed by Invalidate().
+class GLState
+{
+public:
+	static constexpr unsigned int MaxTextureUnits = 32;
+	static constexpr unsigned int MaxUniformBindings = 16;
+
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vertexArray);
+	static void BindBuffer(unsigned int target, unsigned int buffer);
+	// Indexed binding (glBindBufferRange); also changes the generic target binding
+	static void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, unsigned int offset, unsigned int size);
+	// Binds to the given texture unit, switching the active unit if needed
+	static void BindTexture(unsigned int slot, unsigned int target, unsigned int texture);
+	// Binds to whichever unit is currently active (for uploads and parameter changes)
+	static void BindTexture(unsigned int target, unsigned int texture);
+
+	// GL recycles object names, so deleted objects must not stay recorded as bound
+	static void OnProgramDeleted(unsigned int program);
+	static void OnVertexArrayDeleted(unsigned int vertexArray);
+	static void OnBufferDeleted(unsigned int buffer);
+	static void OnTextureDeleted(unsigned int texture);
+
+	// Forget all cached bindings; the next bind of each kind is always issued
+	static void Invalidate();
+
+	// Uniform values are shadowed per program by Shader; it reports here so
+	// the frame stats cover both
+	static void CountUniform(bool issued);
+
+	// Starts a new frame: the counters gathered so far become GetFrameStats()
+	static void BeginFrame();
+	static const GLStateStats& GetFrameStats();
+};
@@ -0,0 +1,229 @@
+#include "GPUProfiler.h"
+
+#include "Renderer.h"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+GPUProfiler::GPUProfiler()
+	: m_Supported(false), m_Current(0), m_HistoryFrames(HistorySize, 0), m_HistoryHead(0),
+	m_HistoryCount(0), m_FrameNumber(0), m_DroppedFrames(0), m_InFrame(false)
+{
+	// Timer queries are core since 3.3
+	m_Supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+	if (!m_Supported)
+		std::cout << "Timer queries not available, GPU profiler disabled" << std::endl;
+}
+
+GPUProfiler::~GPUProfiler()
+{
+	for (FrameQueries& frame : m_Frames)
+	{
+		if (!frame.queries.empty())
+		{
+			GLCall(glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data()));
+		}
+	}
+}
+
+void GPUProfiler::BeginFrame()
+{
+	if (!m_Supported)
+		return;
+
+	// This set was issued FrameLatency frames ago; collect it before reuse
+	FrameQueries& frame = m_Frames[m_Current];
+	if (frame.pending)
+		Resolve(frame);
+
+	frame.used = 0;
+	frame.records.clear();
+	frame.frame = m_FrameNumber;
+	m_OpenScopes.clear();
+	m_InFrame = true;
+
+	BeginScope("Frame");
+}
+
+void GPUProfiler::EndFrame()
+{
+	if (!m_InFrame)
+		return;
+
+	// Close anything left open, including the frame scope
+	while (!m_OpenScopes.empty())
+		EndScope();
+
+	m_Frames[m_Current].pending = true;
+	m_Current = (m_Current + 1) % FrameLatency;
+	m_FrameNumber++;
+	m_InFrame = false;
+}
+
+void GPUProfiler::BeginScope(const char* name)
+{
+	if (!m_InFrame)
+		return;
+
+	FrameQueries& frame = m_Frames[m_Current];
+	ScopeRecord record;
+	record.scope = FindScope(name, static_cast<unsigned int>(m_OpenScopes.size()));
+	record.beginQuery = IssueTimestamp();
+	record.endQuery = record.beginQuery;
+
+	m_OpenScopes.push_back(static_cast<unsigned int>(frame.records.size()));
+	frame.records.push_back(record);
+}
+
+void GPUProfiler::EndScope()
+{
+	if (!m_InFrame || m_OpenScopes.empty())
+		return;
+
+	FrameQueries& frame = m_Frames[m_Current];
+	frame.records[m_OpenScopes.back()].endQuery = IssueTimestamp();
+	m_OpenScopes.pop_back();
+}
+
+unsigned int GPUProfiler::FindScope(const char* name, unsigned int depth)
+{
+	for (unsigned int i = 0; i < m_Scopes.size(); i++)
+	{
+		if (m_Scopes[i].name == name)
+			return i;
+	}
+
+	GPUScopeStats stats;
+	stats.name = name;
+	stats.depth = depth;
+	stats.history.assign(HistorySize, 0.0f);
+	m_Scopes.push_back(stats);
+	return static_cast<unsigned int>(m_Scopes.size() - 1);
+}
+
+unsigned int GPUProfiler::IssueTimestamp()
+{
+	FrameQueries& frame = m_Frames[m_Current];
+	if (frame.used == frame.queries.size())
+	{
+		// Grow in small steps; after the first few frames this never happens
+		const size_t first = frame.queries.size();
+		frame.queries.resize(first + 8);
+		GLCall(glGenQueries(8, frame.queries.data() + first));
+	}
+
+	const unsigned int index = frame.used++;
+	GLCall(glQueryCounter(frame.queries[index], GL_TIMESTAMP));
+	return index;
+}
+
+void GPUProfiler::Resolve(FrameQueries& frame)
+{
+	frame.pending = false;
+	if (frame.used == 0)
+		return;
+
+	// Queries complete in order, so the last one tells whether all are ready
+	GLint available = 0;
+	GLCall(glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+	if (!available)
+	{
+		m_DroppedFrames++;
+		return;
+	}
+
+	std::vector<GLuint64> timestamps(frame.used);
+	for (unsigned int i = 0; i < frame.used; i++)
+	{
+		GLCall(glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]));
+	}
+
+	// A scope may run several times per frame; its samples add up
+	for (GPUScopeStats& scope : m_Scopes)
+		scope.history[m_HistoryHead] = 0.0f;
+	for (const ScopeRecord& record : frame.records)
+	{
+		const GLuint64 begin = timestamps[record.beginQuery];
+		const GLuint64 end = timestamps[record.endQuery];
+		if (end > begin)
+			m_Scopes[record.scope].history[m_HistoryHead] += static_cast<float>((end - begin) / 1.0e6);
+	}
+
+	m_HistoryFrames[m_HistoryHead] = frame.frame;
+	m_HistoryHead = (m_HistoryHead + 1) % HistorySize;
+	m_HistoryCount = std::min(m_HistoryCount + 1, HistorySize);
+
+	const unsigned int newest = (m_HistoryHead + HistorySize - 1) % HistorySize;
+	for (GPUScopeStats& scope : m_Scopes)
+	{
+		float total = 0.0f, max = 0.0f;
+		for (unsigned int i = 0; i < m_HistoryCount; i++)
+		{
+			const float value = scope.history[(newest + HistorySize - i) % HistorySize];
+			total += value;
+			max = std::max(max, value);
+		}
+		scope.last = scope.history[newest];
+		scope.average = total / static_cast<float>(m_HistoryCount);
+		scope.max = max;
+	}
+}
+
+bool GPUProfiler::WriteCSV(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+	{
+		std::cerr << "Failed to write GPU profile to " << path << std::endl;
+		return false;
+	}
+
+	file << "frame";
+	for (const GPUScopeStats& scope : m_Scopes)
+		file << "," << scope.name;
+	file << "\n";
+
+	// Oldest first
+	const unsigned int oldest = (m_HistoryHead + HistorySize - m_HistoryCount) % HistorySize;
+	for (unsigned int i = 0; i < m_HistoryCount; i++)
+	{
+		const unsigned int slot = (oldest + i) % HistorySize;
+		file << m_HistoryFrames[slot];
+		for (const GPUScopeStats& scope : m_Scopes)
+			file << "," << scope.history[slot];
+		file << "\n";
+	}
+	return true;
+}
+
+void GPUProfiler::OnImGuiRender()
+{
+	if (!m_Supported)
+	{
+		ImGui::TextUnformatted("Timer queries not supported");
+		return;
+	}
+
+	ImGui::Text("Resolved %u frames late, %llu dropped", FrameLatency, m_DroppedFrames);
+	for (const GPUScopeStats& scope : m_Scopes)
+	{
+		char overlay[64];
+		std::snprintf(overlay, sizeof(overlay), "%.3f ms (avg %.3f, max %.3f)", scope.last, scope.average, scope.max);
+
+		ImGui::PushID(scope.name.c_str());
+		if (scope.depth > 0)
+			ImGui::Indent(12.0f * scope.depth);
+		ImGui::TextUnformatted(scope.name.c_str());
+		// values_offset makes the graph scroll with the ring
+		ImGui::PlotLines("##history", scope.history.data(), static_cast<int>(HistorySize),
+						 static_cast<int>(m_HistoryHead), overlay, 0.0f, std::max(scope.max * 1.25f, 0.01f),
+						 ImVec2(-1.0f, 40.0f));
+		if (scope.depth > 0)
+			ImGui::Unindent(12.0f * scope.depth);
+		ImGui::PopID();
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct GPUScopeStats
+{
+	std::string name;
+	unsigned int depth = 0;				// nesting level when first seen, for indenting
+	std::vector<float> history;			// milliseconds per resolved frame, ring indexed like GetHistoryHead
+	float last = 0.0f;
+	float average = 0.0f;				// over the resolved frames in history
+	float max = 0.0f;
+};
+
+// GPU timings for named, nestable scopes, measured with GL_TIMESTAMP queries
+// (glQueryCounter) at scope boundaries. Queries go into a ring of
+// FrameLatency per-frame sets and are read back when their set comes round
+// again, so results arrive a few frames late but never wait on the GPU. A
+// set whose results are still not available is dropped rather than stalled
+// on.
+//
+// The frame itself is the first scope ("Frame", BeginFrame to EndFrame);
+// scopes are identified by name and keep a rolling history for graphs and
+// export.
+class GPUProfiler
+{
+public:
+	static constexpr unsigned int FrameLatency = 3;
+	static constexpr unsigned int HistorySize = 240;
+
+private:
+	struct ScopeRecord
+	{
+		unsigned int scope;				// index into m_Scopes
+		unsigned int beginQuery;		// indices into FrameQueries::queries
+		unsigned int endQuery;
+	};
+
+	struct FrameQueries
+	{
+		std::vector<unsigned int> queries;
+		std::vector<ScopeRecord> records;
+		unsigned int used = 0;
+		unsigned long long frame = 0;
+		bool pending = false;
+	};
+
+	bool m_Supported;
+	FrameQueries m_Frames[FrameLatency];
+	unsigned int m_Current;
+	std::vector<unsigned int> m_OpenScopes;		// indices into records of the current frame
+	std::vector<GPUScopeStats> m_Scopes;
+	std::vector<unsigned long long> m_HistoryFrames;
+	unsigned int m_HistoryHead;					// next history slot to write
+	unsigned int m_HistoryCount;
+	unsigned long long m_FrameNumber;
+	unsigned long long m_DroppedFrames;
+	bool m_InFrame;
+public:
+	GPUProfiler();
+	~GPUProfiler();
+
+	GPUProfiler(const GPUProfiler&) = delete;
+	GPUProfiler& operator=(const GPUProfiler&) = delete;
+
+	// Reads back the oldest set of queries, then starts the "Frame" scope
+	void BeginFrame();
+	void EndFrame();
+
+	// Scopes nest and are closed in reverse order within the frame; the
+	// name is copied the first time it is seen
+	void BeginScope(const char* name);
+	void EndScope();
+
+	// Writes the retained history as CSV, one row per frame in milliseconds
+	bool WriteCSV(const std::string& path) const;
+	void OnImGuiRender();
+
+	inline bool IsSupported() const { return m_Supported; }
+	inline const std::vector<GPUScopeStats>& GetScopes() const { return m_Scopes; }
+	inline unsigned int GetHistoryHead() const { return m_HistoryHead; }
+	inline unsigned int GetHistoryCount() const { return m_HistoryCount; }
+	inline unsigned long long GetDroppedFrames() const { return m_DroppedFrames; }
+
+private:
+	unsigned int FindScope(const char* name, unsigned int depth);
+	unsigned int IssueTimestamp();
+	void Resolve(FrameQueries& frame);
+};
+
+// Times the enclosing block
+class GPUProfileScope
+{
+private:
+	GPUProfiler* m_Profiler;
+public:
+	GPUProfileScope(GPUProfiler* profiler, const char* name)
+		: m_Profiler(profiler)
+	{
+		if (m_Profiler)
+			m_Profiler->BeginScope(name);
+	}
+	~GPUProfileScope()
+	{
+		if (m_Profiler)
+			m_Profiler->EndScope();
+	}
+
+	GPUProfileScope(const GPUProfileScope&) = delete;
+	GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+};
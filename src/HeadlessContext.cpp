@@ -0,0 +1,164 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#ifdef OPENGLTHINGY_HAVE_EGL
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+	#include <cstring>
+#endif
+
+HeadlessContext::HeadlessContext()
+	: m_Display(nullptr), m_Context(nullptr), m_Surface(nullptr)
+{
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+#ifdef OPENGLTHINGY_HAVE_EGL
+
+static bool HasExtension(const char* extensions, const char* name)
+{
+	if (!extensions)
+		return false;
+	const size_t length = std::strlen(name);
+	for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + length, name))
+	{
+		const bool startsWord = p == extensions || p[-1] == ' ';
+		const bool endsWord = p[length] == ' ' || p[length] == '\0';
+		if (startsWord && endsWord)
+			return true;
+	}
+	return false;
+}
+
+bool HeadlessContext::Create(int major, int minor)
+{
+	Destroy();
+
+	// Client extensions are queried without a display
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	bool surfaceless = false;
+	EGLDisplay display = EGL_NO_DISPLAY;
+	if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+			eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (getPlatformDisplay)
+		{
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			surfaceless = display != EGL_NO_DISPLAY;
+		}
+	}
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint eglMajor = 0, eglMinor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &eglMajor, &eglMinor))
+	{
+		std::cerr << "EGL: no display available" << std::endl;
+		return false;
+	}
+	m_Display = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cerr << "EGL: desktop OpenGL is not supported" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cerr << "EGL: no suitable config" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	m_Context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (m_Context == EGL_NO_CONTEXT)
+	{
+		m_Context = nullptr;
+		std::cerr << "EGL: failed to create a " << major << "." << minor << " core context (0x"
+			<< std::hex << eglGetError() << std::dec << ")" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	// Without surfaceless contexts a tiny pbuffer keeps MakeCurrent happy;
+	// all rendering goes to a framebuffer object anyway
+	EGLSurface surface = EGL_NO_SURFACE;
+	if (!HasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+		if (surface == EGL_NO_SURFACE)
+		{
+			std::cerr << "EGL: failed to create a pbuffer" << std::endl;
+			Destroy();
+			return false;
+		}
+		m_Surface = surface;
+	}
+
+	if (!eglMakeCurrent(display, surface, surface, static_cast<EGLContext>(m_Context)))
+	{
+		std::cerr << "EGL: failed to make the context current" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	m_Description = "EGL " + std::to_string(eglMajor) + "." + std::to_string(eglMinor) +
+		(surfaceless ? " surfaceless" : m_Surface ? " pbuffer" : " default display");
+	return true;
+}
+
+void HeadlessContext::Destroy()
+{
+	if (!m_Display)
+		return;
+
+	EGLDisplay display = static_cast<EGLDisplay>(m_Display);
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (m_Surface)
+		eglDestroySurface(display, static_cast<EGLSurface>(m_Surface));
+	if (m_Context)
+		eglDestroyContext(display, static_cast<EGLContext>(m_Context));
+	eglTerminate(display);
+
+	m_Display = nullptr;
+	m_Context = nullptr;
+	m_Surface = nullptr;
+	m_Description.clear();
+}
+
+#else
+
+bool HeadlessContext::Create(int /*major*/, int /*minor*/)
+{
+	return false;
+}
+
+void HeadlessContext::Destroy()
+{
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// OpenGL context without a window, created through EGL. Prefers Mesa's
+// surfaceless platform (no display server, works with llvmpipe); otherwise
+// uses the default EGL display with a 1x1 pbuffer. Rendering goes into a
+// Framebuffer, since there is no default framebuffer worth drawing to.
+//
+// Only available when built with EGL (OPENGLTHINGY_HAVE_EGL); Create fails
+// otherwise and the caller falls back to a hidden GLFW window.
+class HeadlessContext
+{
+private:
+	void* m_Display;
+	void* m_Context;
+	void* m_Surface;
+	std::string m_Description;
+public:
+	HeadlessContext();
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// Creates a core profile context of at least the given version and makes it current
+	bool Create(int major, int minor);
+	void Destroy();
+
+	inline bool IsValid() const { return m_Context != nullptr; }
+	// e.g. "EGL 1.5 surfaceless"
+	inline const std::string& GetDescription() const { return m_Description; }
+};
@@ -1,28 +1,37 @@
 #include "IndexBuffer.h"
 
 #include "Renderer.h"
+#include "GLState.h"
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) 
 	: m_Count(count)
 {
 	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID)); //Buffer binding is FUNDAMENTAL
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID); //Buffer binding is FUNDAMENTAL
 	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer() 
 {
 	GLCall(glDeleteBuffers(1, &m_RendererID));
+	GLState::OnBufferDeleted(m_RendererID);
+}
+
+void IndexBuffer::SetSubData(const unsigned int* data, unsigned int count, unsigned int firstIndex)
+{
+	ASSERT(firstIndex + count <= m_Count);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+	GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(unsigned int), count * sizeof(unsigned int), data));
 }
 
 void IndexBuffer::Bind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID)); //Buffer Vertex
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID); //Buffer Vertex
 
 }
 
 void IndexBuffer::Unbind() const
 {
-	GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0)); //Buffer binding is FUNDAMENTAL
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); //Buffer binding is FUNDAMENTAL
 
 }
\ No newline at end of file
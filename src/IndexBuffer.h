@@ -12,5 +12,10 @@ public:
 	void Bind() const;
 	void Unbind() const;
 
+	// Writes count indices starting at index firstIndex, without touching
+	// the element buffer binding of the bound VAO
+	void SetSubData(const unsigned int* data, unsigned int count, unsigned int firstIndex);
+
 	inline unsigned int GetCount() const { return m_Count; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "InstancedCube.h"
+#include "Cube.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "Renderer.h"
+#include "StreamBuffer.h"
+
+#include <algorithm>
+
+// The instance layout below is tightly packed
+static_assert(sizeof(CubeInstance) == 9 * sizeof(float), "CubeInstance must match the instance layout");
+
+/**
+ * @brief Builds a VAO from the cube's vertex/index buffers plus streamed instance data.
+ *
+ * Locations 0-2 come from the cube geometry (per vertex), locations 3-5
+ * from the stream buffer with a divisor of 1 (per instance). The instance
+ * attributes are re-pointed at each frame's allocation in Update.
+ *
+ * @param cube Source geometry
+ * @param stream Stream buffer the instance data is written to
+ * @param maxInstances Maximum number of instances per Update
+ */
+InstancedCube::InstancedCube(const Cube& cube, StreamBuffer& stream, unsigned int maxInstances)
+    : m_cube(cube), m_stream(stream), m_maxInstances(maxInstances) {
+    m_vertexArray = std::make_unique<VertexArray>();
+    m_vertexArray->AddBuffer(cube.GetVertexBuffer(), Cube::GetVertexLayout());
+
+    m_instanceLayout = std::make_unique<VertexBufferLayout>(1);
+    m_instanceLayout->Push<float>(4); // position (xyz), scale (w)
+    m_instanceLayout->Push<float>(4); // rotation axis (xyz), angle (w)
+    m_instanceLayout->Push<float>(1); // texture array layer
+    m_instanceAttrib = m_vertexArray->AddBuffer(stream.GetRendererID(), *m_instanceLayout);
+
+    // The element buffer binding is recorded in the VAO
+    m_vertexArray->Bind();
+    cube.GetIndexBuffer().Bind();
+}
+
+InstancedCube::~InstancedCube() = default;
+
+/**
+ * @brief Uploads instance transforms for the next draw.
+ * @param instances Array of instance transforms
+ * @param count Number of instances
+ */
+void InstancedCube::Update(const CubeInstance* instances, unsigned int count) {
+    m_instanceCount = std::min(count, m_maxInstances);
+    if (m_instanceCount == 0) {
+        return;
+    }
+
+    StreamAllocation allocation = m_stream.Upload(
+        instances, m_instanceCount * static_cast<unsigned int>(sizeof(CubeInstance)));
+    if (!allocation.data) {
+        m_instanceCount = 0; // stream buffer full, skip this frame
+        return;
+    }
+
+    // GL 3.3 has no base instance, so point the instance attributes at this frame's range
+    m_vertexArray->SetBufferOffset(m_instanceAttrib, m_stream.GetRendererID(), *m_instanceLayout, allocation.offset);
+}
+
+/**
+ * @brief Submits all instances as a single draw packet.
+ * @param renderer The renderer instance
+ * @param shader The instanced shader program
+ * @param texture Optional texture (or texture array) for slot 0
+ * @param shaderVariant Keyword bits of the shader variant
+ */
+void InstancedCube::Render(Renderer& renderer, const Shader& shader, const Texture* texture,
+                           unsigned int shaderVariant) const {
+    if (m_instanceCount == 0) {
+        return;
+    }
+
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.shaderVariant = shaderVariant;
+    packet.vertexArray = m_vertexArray.get();
+    packet.indexBuffer = &m_cube.GetIndexBuffer();
+    if (texture) {
+        packet.textures[0] = texture;
+        packet.textureCount = 1;
+    }
+    packet.instanceCount = m_instanceCount;
+    packet.blend = BlendMode::Opaque;
+
+    renderer.Submit(packet);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <glm/glm.hpp>
+
+class Cube;
+class VertexArray;
+class VertexBufferLayout;
+class StreamBuffer;
+class Shader;
+class Renderer;
+class Texture;
+
+/**
+ * @brief Compact per-instance transform and texture layer, 36 bytes per cube.
+ *
+ * The vertex shader rebuilds the model matrix from these values, which
+ * halves the streamed data compared to a full mat4 per instance.
+ */
+struct CubeInstance {
+    glm::vec4 positionScale; // world position (xyz), uniform scale (w)
+    glm::vec4 rotation;      // rotation axis (xyz, normalized), angle in radians (w)
+    float layer = 0.0f;      // texture array layer (USE_TEXTURE_ARRAY variant)
+};
+
+/**
+ * @brief Draws many copies of a cube's geometry in a single instanced draw call.
+ *
+ * Shares the vertex and index buffers of an existing Cube; per-instance data
+ * (attribute locations 3 to 5, divisor 1) is written into the renderer's
+ * stream buffer each frame.
+ * Meant to be used with res/shaders/CubeInstanced.shader.
+ */
+class InstancedCube {
+public:
+    /**
+     * @brief Creates a VAO combining the cube geometry with streamed instance data.
+     * @param cube The cube whose geometry is instanced; must outlive this object
+     * @param stream Stream buffer instance data is allocated from; must outlive this object
+     * @param maxInstances Maximum number of instances per Update
+     */
+    InstancedCube(const Cube& cube, StreamBuffer& stream, unsigned int maxInstances);
+    ~InstancedCube();
+
+    InstancedCube(const InstancedCube&) = delete;
+    InstancedCube& operator=(const InstancedCube&) = delete;
+
+    /**
+     * @brief Streams new instance data to the GPU. Call once per frame, after
+     *        Renderer::BeginFrame and before the instances are drawn.
+     * @param instances Array of instance transforms
+     * @param count Number of instances, clamped to the capacity
+     */
+    void Update(const CubeInstance* instances, unsigned int count);
+
+    /**
+     * @brief Submits one instanced draw of all uploaded instances.
+     * @param renderer The renderer to submit to
+     * @param shader The instanced cube shader (expects u_ViewProjection set by the caller)
+     * @param texture Optional texture bound to slot 0
+     * @param shaderVariant Keyword bits of the shader variant to draw with
+     */
+    void Render(Renderer& renderer, const Shader& shader, const Texture* texture = nullptr,
+                unsigned int shaderVariant = 0) const;
+
+    inline unsigned int GetInstanceCount() const { return m_instanceCount; }
+    inline unsigned int GetMaxInstances() const { return m_maxInstances; }
+
+private:
+    const Cube& m_cube;
+    std::unique_ptr<VertexArray> m_vertexArray;
+    StreamBuffer& m_stream;
+    std::unique_ptr<VertexBufferLayout> m_instanceLayout;
+    unsigned int m_instanceAttrib = 0; // first attribute location of the instance layout
+    unsigned int m_maxInstances;
+    unsigned int m_instanceCount = 0;
+};
@@ -0,0 +1,88 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+	: m_Data(nullptr), m_Size(0), m_Open(false)
+#ifdef _WIN32
+	, m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr)
+#endif
+{
+#ifdef _WIN32
+	m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size))
+		return;
+	m_Size = static_cast<size_t>(size.QuadPart);
+	if (m_Size > 0)
+	{
+		m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_Mapping)
+			m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_Data)
+			return;
+	}
+	m_Open = true;
+#else
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+	{
+		m_Size = static_cast<size_t>(info.st_size);
+		m_Open = true;
+		if (m_Size > 0)
+		{
+			void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED)
+				m_Open = false;
+			else
+				m_Data = static_cast<const char*>(data);
+		}
+	}
+	// The mapping keeps the file alive
+	close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_Data)
+		UnmapViewOfFile(m_Data);
+	if (m_Mapping)
+		CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE)
+		CloseHandle(m_File);
+#else
+	if (m_Data)
+		munmap(const_cast<char*>(m_Data), m_Size);
+#endif
+}
+
+void MappedFile::Prefetch() const
+{
+	if (!m_Data)
+		return;
+#ifdef _WIN32
+	// Touching a byte per page faults them in now, on the calling thread
+	volatile char sink = 0;
+	for (size_t offset = 0; offset < m_Size; offset += 4096)
+		sink = sink + m_Data[offset];
+#else
+	madvise(const_cast<char*>(m_Data), m_Size, MADV_WILLNEED);
+#endif
+}
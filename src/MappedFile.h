@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only view of a whole file (mmap / MapViewOfFile). An empty file is
+// open with a null GetData().
+class MappedFile
+{
+private:
+	const char* m_Data;
+	size_t m_Size;
+	bool m_Open;
+#ifdef _WIN32
+	void* m_File;		// HANDLEs
+	void* m_Mapping;
+#endif
+public:
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Starts reading the whole file in ahead of first use (madvise; on
+	// Windows by touching every page, so it blocks)
+	void Prefetch() const;
+
+	inline bool IsOpen() const { return m_Open; }
+	inline const char* GetData() const { return m_Data; }
+	inline size_t GetSize() const { return m_Open ? m_Size : 0; }
+};
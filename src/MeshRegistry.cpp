@@ -0,0 +1,141 @@
+#include "MeshRegistry.h"
+
+#include "Renderer.h"
+#include "GLState.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+
+#include <cstdint>
+#include <iostream>
+
+MeshRegistry::MeshRegistry(StreamBuffer& stream, const VertexBufferLayout& vertexLayout, unsigned int maxVertices, unsigned int maxIndices)
+	: m_Stream(stream), m_VertexStride(vertexLayout.GetStride()), m_MaxVertices(maxVertices), m_MaxIndices(maxIndices),
+	m_VertexCount(0), m_IndexCount(0), m_InstanceAttrib(0)
+{
+	// baseInstance in indirect commands is only honored with ARB_base_instance (core in 4.2)
+	m_Indirect = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+
+	m_VertexArray = std::make_unique<VertexArray>();
+	m_VertexBuffer = std::make_unique<VertexBuffer>(nullptr, maxVertices * m_VertexStride, GL_STATIC_DRAW);
+	m_VertexArray->AddBuffer(*m_VertexBuffer, vertexLayout);
+
+	// The element buffer binding is recorded in the VAO
+	m_VertexArray->Bind();
+	m_IndexBuffer = std::make_unique<IndexBuffer>(nullptr, maxIndices);
+}
+
+MeshRegistry::~MeshRegistry() = default;
+
+MeshHandle MeshRegistry::Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+	MeshHandle handle;
+	if (m_VertexCount + vertexCount > m_MaxVertices || m_IndexCount + indexCount > m_MaxIndices)
+	{
+		std::cout << "Warning: mesh registry full (" << m_MaxVertices << " vertices, " << m_MaxIndices << " indices)" << std::endl;
+		return handle;
+	}
+
+	m_VertexBuffer->SetSubData(vertices, vertexCount * m_VertexStride, m_VertexCount * m_VertexStride);
+	m_IndexBuffer->SetSubData(indices, indexCount, m_IndexCount);
+
+	// Indices stay mesh-relative; the base vertex moves them to the mesh's range
+	m_Meshes.push_back({ m_IndexCount, indexCount, static_cast<int>(m_VertexCount), vertexCount });
+	m_VertexCount += vertexCount;
+	m_IndexCount += indexCount;
+
+	handle.id = static_cast<unsigned int>(m_Meshes.size() - 1);
+	return handle;
+}
+
+const MeshRange& MeshRegistry::GetRange(MeshHandle mesh) const
+{
+	ASSERT(mesh.id < m_Meshes.size());
+	return m_Meshes[mesh.id];
+}
+
+void MeshRegistry::SetInstanceLayout(const VertexBufferLayout& layout)
+{
+	ASSERT(!m_InstanceLayout);
+	m_InstanceLayout = std::make_unique<VertexBufferLayout>(layout);
+	m_InstanceAttrib = m_VertexArray->AddBuffer(m_Stream.GetRendererID(), *m_InstanceLayout);
+}
+
+void MeshRegistry::Draw(const MeshDrawCommand* commands, unsigned int count, const StreamAllocation& instances)
+{
+	m_Stats = MeshDrawStats();
+	if (count == 0)
+		return;
+	if (m_InstanceLayout && !instances.data)
+		return; // instance upload failed, nothing sensible to draw
+
+	m_VertexArray->Bind();
+
+	if (m_Indirect)
+	{
+		// baseInstance of each command is relative to this frame's instance data
+		if (m_InstanceLayout)
+			m_VertexArray->SetBufferOffset(m_InstanceAttrib, m_Stream.GetRendererID(), *m_InstanceLayout, instances.offset);
+
+		m_IndirectCommands.clear();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const MeshRange& range = GetRange(commands[i].mesh);
+			m_IndirectCommands.push_back({ range.indexCount, commands[i].instanceCount, range.firstIndex,
+				range.baseVertex, commands[i].firstInstance });
+		}
+
+		StreamAllocation buffer = m_Stream.Upload(m_IndirectCommands.data(),
+			count * static_cast<unsigned int>(sizeof(IndirectCommand)), 4);
+		if (!buffer.data)
+			return;
+
+		m_Stream.Bind(GL_DRAW_INDIRECT_BUFFER);
+		GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(buffer.offset)), count, 0));
+		m_Stats.commands = count;
+		m_Stats.apiCalls = 1;
+		return;
+	}
+
+	bool singleInstances = !m_InstanceLayout;
+	for (unsigned int i = 0; i < count && singleInstances; i++)
+		singleInstances = commands[i].instanceCount == 1;
+
+	if (singleInstances)
+	{
+		m_Counts.clear();
+		m_Offsets.clear();
+		m_BaseVertices.clear();
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const MeshRange& range = GetRange(commands[i].mesh);
+			m_Counts.push_back(static_cast<GLsizei>(range.indexCount));
+			m_Offsets.push_back(reinterpret_cast<void*>(static_cast<uintptr_t>(range.firstIndex) * sizeof(unsigned int)));
+			m_BaseVertices.push_back(range.baseVertex);
+		}
+
+		GLCall(glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_Counts.data(), GL_UNSIGNED_INT,
+			m_Offsets.data(), static_cast<GLsizei>(count), m_BaseVertices.data()));
+		m_Stats.commands = count;
+		m_Stats.apiCalls = 1;
+		return;
+	}
+
+	// GL 3.3 can't offset instance attributes per draw, so re-point them for every command
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const MeshRange& range = GetRange(commands[i].mesh);
+		if (m_InstanceLayout)
+		{
+			const unsigned int offset = instances.offset + commands[i].firstInstance * m_InstanceLayout->GetStride();
+			m_VertexArray->SetBufferOffset(m_InstanceAttrib, m_Stream.GetRendererID(), *m_InstanceLayout, offset);
+		}
+
+		GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(static_cast<uintptr_t>(range.firstIndex) * sizeof(unsigned int)),
+			commands[i].instanceCount, range.baseVertex));
+		m_Stats.apiCalls++;
+	}
+	m_Stats.commands = count;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "VertexBufferLayout.h"
+#include "StreamBuffer.h"
+
+class VertexArray;
+class VertexBuffer;
+class IndexBuffer;
+
+struct MeshHandle
+{
+	unsigned int id = ~0u;
+
+	inline bool IsValid() const { return id != ~0u; }
+};
+
+// Where a mesh lives inside the shared buffers
+struct MeshRange
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	int baseVertex;
+	unsigned int vertexCount;
+};
+
+struct MeshDrawCommand
+{
+	MeshHandle mesh;
+	unsigned int instanceCount = 1;
+	unsigned int firstInstance = 0;	// into the instance data passed to Draw
+};
+
+struct MeshDrawStats
+{
+	unsigned int commands = 0;
+	unsigned int apiCalls = 0;		// draw calls that reached the driver
+};
+
+// Packs many meshes with the same vertex layout into one vertex buffer and
+// one index buffer behind a single VAO, so a scene made of different meshes
+// needs one VAO bind and, with ARB_multi_draw_indirect, one draw call:
+//
+//	MeshRegistry meshes(stream, Cube::GetVertexLayout(), 65536, 262144);
+//	MeshHandle cube = meshes.Add(vertices, vertexCount, indices, indexCount);
+//	...
+//	shader.Bind();
+//	meshes.Draw(commands, commandCount, instanceData);
+//
+// Per-instance attributes (SetInstanceLayout) follow the vertex attributes;
+// each frame's instance data is a StreamBuffer allocation and a command's
+// firstInstance indexes into it.
+//
+// Without indirect draws (GL 3.3), commands are issued with
+// glMultiDrawElementsBaseVertex when there is no per-instance data, and as
+// one instanced draw per command otherwise, since 3.3 has no base instance.
+class MeshRegistry
+{
+private:
+	struct IndirectCommand
+	{
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	StreamBuffer& m_Stream;
+	std::unique_ptr<VertexArray> m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	unsigned int m_VertexStride;
+	unsigned int m_MaxVertices;
+	unsigned int m_MaxIndices;
+	unsigned int m_VertexCount;
+	unsigned int m_IndexCount;
+	std::vector<MeshRange> m_Meshes;
+
+	std::unique_ptr<VertexBufferLayout> m_InstanceLayout;
+	unsigned int m_InstanceAttrib;
+	bool m_Indirect;
+
+	// Scratch arrays reused by Draw
+	std::vector<IndirectCommand> m_IndirectCommands;
+	std::vector<GLsizei> m_Counts;
+	std::vector<void*> m_Offsets;
+	std::vector<GLint> m_BaseVertices;
+	MeshDrawStats m_Stats;
+public:
+	MeshRegistry(StreamBuffer& stream, const VertexBufferLayout& vertexLayout, unsigned int maxVertices, unsigned int maxIndices);
+	~MeshRegistry();
+
+	MeshRegistry(const MeshRegistry&) = delete;
+	MeshRegistry& operator=(const MeshRegistry&) = delete;
+
+	// Copies a mesh into the shared buffers. Indices are relative to the
+	// mesh's own vertices. Returns an invalid handle if the buffers are full.
+	MeshHandle Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+	const MeshRange& GetRange(MeshHandle mesh) const;
+
+	// Adds per-instance attributes (divisor > 0) after the vertex attributes
+	void SetInstanceLayout(const VertexBufferLayout& layout);
+
+	// Draws the commands with the currently bound shader. instances is this
+	// frame's per-instance data; it is required if an instance layout is set.
+	void Draw(const MeshDrawCommand* commands, unsigned int count, const StreamAllocation& instances = StreamAllocation());
+
+	inline unsigned int GetMeshCount() const { return static_cast<unsigned int>(m_Meshes.size()); }
+	inline bool IsIndirect() const { return m_Indirect; }
+	// Stats of the last Draw
+	inline const MeshDrawStats& GetStats() const { return m_Stats; }
+};
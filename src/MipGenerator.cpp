@@ -0,0 +1,237 @@
+#include "MipGenerator.h"
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MIPGEN_SSE2 1
+	#include <emmintrin.h>
+#endif
+
+namespace {
+
+	struct CacheFileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceSize;		// bytes of the image file
+		std::int64_t sourceTime;		// its write time, in file_time_type ticks
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levels;
+		std::uint32_t reserved;
+	};
+
+	constexpr char CacheMagic[4] = { 'O', 'G', 'T', 'M' };
+	// Bump when the header or the filter changes
+	constexpr std::uint32_t CacheVersion = 1;
+
+	constexpr int EncodeSteps = 4096;
+
+	// sRGB <-> linear, by table: 256 entries in, 4096 steps out
+	struct SrgbTables
+	{
+		float toLinear[256];
+		unsigned char toSrgb[EncodeSteps];
+
+		SrgbTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const float c = i / 255.0f;
+				toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < EncodeSteps; i++)
+			{
+				const float l = i / float(EncodeSteps - 1);
+				const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+				toSrgb[i] = static_cast<unsigned char>(std::min(std::max(c * 255.0f + 0.5f, 0.0f), 255.0f));
+			}
+		}
+	};
+
+	const SrgbTables& GetTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	// RGBA8 -> premultiplied linear float RGBA
+	void Decode(const unsigned char* source, size_t count, float* target)
+	{
+		const SrgbTables& tables = GetTables();
+		for (size_t i = 0; i < count; i++, source += 4, target += 4)
+		{
+			const float alpha = source[3] / 255.0f;
+			target[0] = tables.toLinear[source[0]] * alpha;
+			target[1] = tables.toLinear[source[1]] * alpha;
+			target[2] = tables.toLinear[source[2]] * alpha;
+			target[3] = alpha;
+		}
+	}
+
+	// Premultiplied linear float RGBA -> RGBA8
+	void Encode(const float* source, size_t count, unsigned char* target)
+	{
+		const SrgbTables& tables = GetTables();
+		for (size_t i = 0; i < count; i++, source += 4, target += 4)
+		{
+			const float alpha = source[3];
+			const float scale = alpha > 0.0f ? float(EncodeSteps - 1) / alpha : 0.0f;
+			for (int c = 0; c < 3; c++)
+			{
+				const int step = static_cast<int>(source[c] * scale + 0.5f);
+				target[c] = tables.toSrgb[std::min(std::max(step, 0), EncodeSteps - 1)];
+			}
+			target[3] = static_cast<unsigned char>(std::min(std::max(alpha * 255.0f + 0.5f, 0.0f), 255.0f));
+		}
+	}
+
+	// One 2x2 box step between float RGBA levels
+	void Downsample(const float* source, int sourceWidth, int sourceHeight, float* target, int width, int height)
+	{
+		for (int y = 0; y < height; y++)
+		{
+			const float* row0 = source + size_t(std::min(2 * y, sourceHeight - 1)) * sourceWidth * 4;
+			const float* row1 = source + size_t(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth * 4;
+			float* out = target + size_t(y) * width * 4;
+			for (int x = 0; x < width; x++, out += 4)
+			{
+				const size_t x0 = size_t(std::min(2 * x, sourceWidth - 1)) * 4;
+				const size_t x1 = size_t(std::min(2 * x + 1, sourceWidth - 1)) * 4;
+#ifdef MIPGEN_SSE2
+				// One pixel is one register
+				const __m128 sum = _mm_add_ps(
+					_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+					_mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+				_mm_storeu_ps(out, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+				for (int c = 0; c < 4; c++)
+					out[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+#endif
+			}
+		}
+	}
+
+	std::string CachePath(const std::string& imagePath)
+	{
+		return imagePath + MipGenerator::CacheExtension;
+	}
+
+	size_t ChainSize(int width, int height, std::vector<MipLevel>& levels, size_t levelLimit = 0)
+	{
+		size_t offset = 0;
+		levels.clear();
+		for (;;)
+		{
+			levels.push_back({ width, height, offset });
+			offset += size_t(width) * height * 4;
+			if ((width == 1 && height == 1) || levels.size() == levelLimit)
+				return offset;
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+	}
+
+}
+
+void MipGenerator::Build(const unsigned char* image, int width, int height, MipChain& chain, size_t levelLimit /*= 0*/)
+{
+	chain.pixels.resize(ChainSize(width, height, chain.levels, levelLimit));
+	std::memcpy(chain.pixels.data(), image, size_t(width) * height * 4);
+	if (chain.levels.size() == 1)
+		return;
+
+	// Two float levels at a time; the chain never goes back through 8 bits
+	std::vector<float> current(size_t(width) * height * 4);
+	std::vector<float> next(size_t(std::max(width / 2, 1)) * std::max(height / 2, 1) * 4);
+	Decode(image, size_t(width) * height, current.data());
+
+	for (size_t level = 1; level < chain.levels.size(); level++)
+	{
+		const MipLevel& source = chain.levels[level - 1];
+		const MipLevel& target = chain.levels[level];
+		Downsample(current.data(), source.width, source.height, next.data(), target.width, target.height);
+		Encode(next.data(), size_t(target.width) * target.height, chain.pixels.data() + target.offset);
+		std::swap(current, next);
+	}
+}
+
+bool MipGenerator::LoadCached(const std::string& imagePath, MipChain& chain)
+{
+	std::uint64_t sourceSize = 0;
+	std::int64_t sourceTime = 0;
+	if (!AssetPack::GetSourceStamp(imagePath, sourceSize, sourceTime))
+		return false;
+
+	std::ifstream file(CachePath(imagePath), std::ios::binary);
+	if (!file)
+		return false;
+
+	CacheFileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+		header.version != CacheVersion ||
+		header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+		header.width == 0 || header.height == 0 || header.width > 65536 || header.height > 65536)
+	{
+		return false;
+	}
+
+	const size_t size = ChainSize(static_cast<int>(header.width), static_cast<int>(header.height), chain.levels);
+	if (header.levels != chain.levels.size())
+		return false;
+	chain.pixels.resize(size);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(chain.pixels.data()), size));
+}
+
+void MipGenerator::StoreCached(const std::string& imagePath, const MipChain& chain)
+{
+	CacheFileHeader header = {};
+	if (chain.levels.empty() || !AssetPack::GetSourceStamp(imagePath, header.sourceSize, header.sourceTime))
+		return;
+	std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+	header.version = CacheVersion;
+	header.width = static_cast<std::uint32_t>(chain.levels[0].width);
+	header.height = static_cast<std::uint32_t>(chain.levels[0].height);
+	header.levels = static_cast<std::uint32_t>(chain.levels.size());
+
+	// Write to a temporary and rename, so a reader never sees half an entry
+	const std::string path = CachePath(imagePath);
+	// Per thread: two workers may be storing the same image at once
+	const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::error_code error;
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(chain.pixels.data()), chain.pixels.size());
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+		std::filesystem::remove(temporary, error);
+}
+
+bool MipGenerator::IsSimd()
+{
+#ifdef MIPGEN_SSE2
+	return true;
+#else
+	return false;
+#endif
+}
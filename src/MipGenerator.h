@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct MipLevel
+{
+	int width;
+	int height;
+	size_t offset;		// into MipChain::pixels
+};
+
+// An RGBA8 image and its mip levels, back to back in one allocation so the
+// whole chain can be uploaded from a single buffer
+struct MipChain
+{
+	std::vector<MipLevel> levels;		// [0] is the full-size image
+	std::vector<unsigned char> pixels;
+
+	inline const unsigned char* GetLevel(size_t level) const { return pixels.data() + levels[level].offset; }
+};
+
+// CPU mip chain generation, for worker threads and offline use.
+//
+// Levels are 2x2 box-filtered in linear light: colours are decoded from
+// sRGB, premultiplied by alpha, averaged, then re-encoded, so downsampled
+// levels keep the brightness and edges of the original instead of
+// darkening as averaging gamma-encoded values does. The chain is carried
+// in float between levels, with SSE2 doing the filtering where available.
+// Odd sizes round down, repeating the last row/column.
+//
+// A finished chain can be cached next to its image ("<image>.mips"); the
+// entry is valid while the image's size and write time are unchanged, and
+// loading it skips both decoding and downsampling.
+class MipGenerator
+{
+public:
+	static constexpr const char* CacheExtension = ".mips";
+
+	// Replaces chain with width x height RGBA8 pixels plus every level down
+	// to 1x1, or only the first levelLimit levels when that is non-zero
+	static void Build(const unsigned char* image, int width, int height, MipChain& chain, size_t levelLimit = 0);
+
+	static bool LoadCached(const std::string& imagePath, MipChain& chain);
+	// Failures (read-only directories, ...) only cost the next load
+	static void StoreCached(const std::string& imagePath, const MipChain& chain);
+
+	// Whether Build uses the SSE2 path
+	static bool IsSimd();
+};
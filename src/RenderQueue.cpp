@@ -0,0 +1,119 @@
+#include "RenderQueue.h"
+
+#include "Renderer.h"
+#include "Texture.h"
+
+#include <algorithm>
+
+// Key layout (most significant bits first):
+//   Opaque:         [63:62] pass | [61:48] program | [47:36] texture | [35:24] vertex array | [23:0] depth
+//   Alpha/Overlay:  [63:62] pass | [61:38] inverted depth | [37:24] program | [23:12] texture | [11:0] vertex array
+// Object ids are truncated to their field width. A collision only costs an
+// extra state change, since the packet itself still carries the real objects.
+static constexpr uint64_t DEPTH_BITS = 24;
+static constexpr uint64_t PROGRAM_BITS = 14;
+static constexpr uint64_t TEXTURE_BITS = 12;
+static constexpr uint64_t VERTEX_ARRAY_BITS = 12;
+
+static inline uint64_t Field(uint64_t value, uint64_t bits)
+{
+	return value & ((uint64_t(1) << bits) - 1);
+}
+
+RenderQueue::RenderQueue(unsigned int reserve)
+{
+	m_Packets.reserve(reserve);
+	m_Items.reserve(reserve);
+	m_Scratch.reserve(reserve);
+}
+
+void RenderQueue::Submit(const DrawPacket& packet)
+{
+	m_Items.push_back({ MakeKey(packet), static_cast<uint32_t>(m_Packets.size()) });
+	m_Packets.push_back(packet);
+}
+
+void RenderQueue::Sort()
+{
+	RadixSort();
+}
+
+void RenderQueue::Clear()
+{
+	// clear() keeps the capacity, so next frame's submissions reuse the storage
+	m_Packets.clear();
+	m_Items.clear();
+}
+
+uint64_t RenderQueue::MakeKey(const DrawPacket& packet)
+{
+	const uint64_t program = packet.shader ? packet.shader->GetRendererID(packet.shaderVariant) : 0;
+	const uint64_t texture = packet.textureCount > 0 && packet.textures[0] ? packet.textures[0]->GetRendererID() : 0;
+	const uint64_t vertexArray = packet.vertexArray ? packet.vertexArray->GetRendererID() : 0;
+
+	const float clamped = std::min(std::max(packet.depth, 0.0f), 1.0f);
+	const uint64_t depthMax = (uint64_t(1) << DEPTH_BITS) - 1;
+	const uint64_t depth = static_cast<uint64_t>(clamped * static_cast<float>(depthMax));
+
+	uint64_t key = static_cast<uint64_t>(packet.blend) << 62;
+	if (packet.blend == BlendMode::Opaque)
+	{
+		key |= Field(program, PROGRAM_BITS) << 48;
+		key |= Field(texture, TEXTURE_BITS) << 36;
+		key |= Field(vertexArray, VERTEX_ARRAY_BITS) << 24;
+		key |= depth;
+	}
+	else
+	{
+		key |= (depthMax - depth) << 38;
+		key |= Field(program, PROGRAM_BITS) << 24;
+		key |= Field(texture, TEXTURE_BITS) << 12;
+		key |= Field(vertexArray, VERTEX_ARRAY_BITS);
+	}
+	return key;
+}
+
+// LSD radix sort over 8-bit digits. All eight histograms are built in a
+// single pass, and digits on which every key agrees are skipped, so a
+// typical frame only pays for the few bytes that actually vary.
+// The sort is stable, so packets with equal keys keep submission order.
+void RenderQueue::RadixSort()
+{
+	const size_t count = m_Items.size();
+	if (count < 2)
+		return;
+
+	uint32_t histograms[8][256] = {};
+	for (const SortItem& item : m_Items)
+	{
+		for (unsigned int digit = 0; digit < 8; digit++)
+			histograms[digit][(item.key >> (digit * 8)) & 0xFF]++;
+	}
+
+	m_Scratch.resize(count);
+	SortItem* src = m_Items.data();
+	SortItem* dst = m_Scratch.data();
+
+	for (unsigned int digit = 0; digit < 8; digit++)
+	{
+		uint32_t* histogram = histograms[digit];
+		if (histogram[(src[0].key >> (digit * 8)) & 0xFF] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; bucket++)
+		{
+			const uint32_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+			dst[histogram[(src[i].key >> (digit * 8)) & 0xFF]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != m_Items.data())
+		std::copy(src, src + count, m_Items.data());
+}
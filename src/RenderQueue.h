@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Shader;
+class VertexArray;
+class IndexBuffer;
+class Texture;
+
+// Blend mode doubles as the render pass a packet belongs to; passes are
+// drawn in enum order.
+enum class BlendMode : unsigned char
+{
+	Opaque = 0,		// depth tested, blending off, grouped by state then front-to-back
+	Alpha = 1,		// depth tested, blending on, back-to-front
+	Overlay = 2		// depth test off, blending on, back-to-front (2D content)
+};
+
+struct DrawPacket
+{
+	static constexpr unsigned int MaxTextures = 4;
+
+	const Shader* shader = nullptr;
+	unsigned int shaderVariant = 0;				// keyword bits, see Shader::GetKeyword
+	const VertexArray* vertexArray = nullptr;
+	const IndexBuffer* indexBuffer = nullptr;
+	const Texture* textures[MaxTextures] = {};	// bound to slots 0..textureCount-1
+	unsigned int textureCount = 0;
+	unsigned int instanceCount = 1;				// > 1 issues an instanced draw
+	float depth = 0.0f;							// normalized device depth in [0, 1]
+	BlendMode blend = BlendMode::Opaque;
+
+	glm::mat4 mvp = glm::mat4(1.0f);			// uploaded as u_MVP if the shader declares it
+	glm::mat4 model = glm::mat4(1.0f);			// uploaded as u_Model if the shader declares it
+};
+
+// Collects draw packets for a frame and orders them by a packed 64-bit
+// sort key so that consecutive draws share as much GL state as possible.
+// Storage is kept between frames: once the queue has grown to the size of
+// the scene, Submit and Sort do not allocate.
+class RenderQueue
+{
+private:
+	struct SortItem
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	std::vector<DrawPacket> m_Packets;
+	std::vector<SortItem> m_Items;
+	std::vector<SortItem> m_Scratch;
+public:
+	RenderQueue(unsigned int reserve = 1024);
+
+	void Submit(const DrawPacket& packet);
+	void Sort();
+	void Clear();
+
+	inline unsigned int GetSize() const { return static_cast<unsigned int>(m_Items.size()); }
+	// Packet at position i of the sorted order (valid after Sort)
+	inline const DrawPacket& operator[](unsigned int i) const { return m_Packets[m_Items[i].index]; }
+
+	static uint64_t MakeKey(const DrawPacket& packet);
+
+private:
+	void RadixSort();
+};
@@ -1,7 +1,13 @@
 #include "Renderer.h"
+#include "Texture.h"
+#include "StreamBuffer.h"
 
 #include <iostream>
 
+// Per-draw matrices, uploaded when the packet's shader declares them
+static constexpr UniformName U_MVP("u_MVP");
+static constexpr UniformName U_MODEL("u_Model");
+
 void GLClearError()
 {
 	while (glGetError() != GL_NO_ERROR);
@@ -13,11 +19,29 @@ bool GLLogCall(const char* function, const char* file, int line)
 	{
 		std::cout << "[OpenGL Error] (" << error << ")" << function << " " << file <<
 			":" << line << std::endl;
+		GLDebug::DumpCallHistory(std::cout);
 		return false;
 	}
 	return true;
 };
 
+Renderer::Renderer(unsigned int streamBufferFrameSize)
+	: m_StreamBuffer(std::make_unique<StreamBuffer>(streamBufferFrameSize))
+{
+}
+
+Renderer::~Renderer() = default;
+
+void Renderer::BeginFrame()
+{
+	m_StreamBuffer->BeginFrame();
+}
+
+void Renderer::EndFrame()
+{
+	m_StreamBuffer->EndFrame();
+}
+
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
 	shader.Bind();
@@ -29,4 +53,106 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
 void Renderer::Clear() const
 {
 	GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+}
+
+void Renderer::Submit(const DrawPacket& packet)
+{
+	m_Queue.Submit(packet);
+}
+
+void Renderer::Flush()
+{
+	m_Stats = RenderStats();
+	m_Queue.Sort();
+
+	const Shader* boundShader = nullptr;
+	unsigned int boundVariant = 0;
+	UniformHandle mvpUniform, modelUniform;		// of boundShader
+	const VertexArray* boundVertexArray = nullptr;
+	const IndexBuffer* boundIndexBuffer = nullptr;
+	const Texture* boundTextures[DrawPacket::MaxTextures] = {};
+	bool firstPacket = true;
+	BlendMode blend = BlendMode::Opaque;
+
+	for (unsigned int i = 0; i < m_Queue.GetSize(); i++)
+	{
+		const DrawPacket& packet = m_Queue[i];
+		if (!packet.shader || !packet.vertexArray || !packet.indexBuffer)
+			continue;
+
+		if (firstPacket || packet.blend != blend)
+		{
+			blend = packet.blend;
+			if (blend == BlendMode::Opaque)
+			{
+				GLCall(glDisable(GL_BLEND));
+			}
+			else
+			{
+				GLCall(glEnable(GL_BLEND));
+			}
+
+			if (blend == BlendMode::Overlay)
+			{
+				GLCall(glDisable(GL_DEPTH_TEST));
+			}
+			else
+			{
+				GLCall(glEnable(GL_DEPTH_TEST));
+			}
+			firstPacket = false;
+		}
+
+		if (packet.shader != boundShader || packet.shaderVariant != boundVariant)
+		{
+			packet.shader->Bind(packet.shaderVariant);
+			boundShader = packet.shader;
+			boundVariant = packet.shaderVariant;
+			mvpUniform = boundShader->FindUniform(U_MVP);
+			modelUniform = boundShader->FindUniform(U_MODEL);
+			m_Stats.shaderChanges++;
+		}
+		if (packet.vertexArray != boundVertexArray)
+		{
+			packet.vertexArray->Bind();
+			boundVertexArray = packet.vertexArray;
+			boundIndexBuffer = nullptr; // element buffer binding is part of VAO state
+			m_Stats.vertexArrayChanges++;
+		}
+		if (packet.indexBuffer != boundIndexBuffer)
+		{
+			packet.indexBuffer->Bind();
+			boundIndexBuffer = packet.indexBuffer;
+		}
+		for (unsigned int slot = 0; slot < packet.textureCount && slot < DrawPacket::MaxTextures; slot++)
+		{
+			if (packet.textures[slot] && packet.textures[slot] != boundTextures[slot])
+			{
+				packet.textures[slot]->Bind(slot);
+				boundTextures[slot] = packet.textures[slot];
+				m_Stats.textureChanges++;
+			}
+		}
+
+		if (mvpUniform.IsValid())
+			packet.shader->SetUniformMat4f(mvpUniform, packet.mvp);
+		if (modelUniform.IsValid())
+			packet.shader->SetUniformMat4f(modelUniform, packet.model);
+
+		if (packet.instanceCount > 1)
+		{
+			GLCall(glDrawElementsInstanced(GL_TRIANGLES, packet.indexBuffer->GetCount(), GL_UNSIGNED_INT, nullptr, packet.instanceCount));
+		}
+		else
+		{
+			GLCall(glDrawElements(GL_TRIANGLES, packet.indexBuffer->GetCount(), GL_UNSIGNED_INT, nullptr));
+		}
+		m_Stats.drawCalls++;
+	}
+
+	// Restore the default state set up in OpenGLApp::InitializeOpenGL
+	GLCall(glEnable(GL_BLEND));
+	GLCall(glEnable(GL_DEPTH_TEST));
+
+	m_Queue.Clear();
 }
\ No newline at end of file
@@ -2,9 +2,15 @@
 
 #include <GL/glew.h>
 
+#include <memory>
+
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "RenderQueue.h"
+#include "GLDebug.h"
+
+class StreamBuffer;
 
 #ifdef _WIN32
     #define ASSERT(x) if (!(x)) __debugbreak();
@@ -12,19 +18,55 @@
     #include <signal.h>
     #define ASSERT(x) if (!(x)) raise(SIGTRAP);
 #endif
-#define GLCall(x) GLClearError();\
-	x;\
-	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+// Wrap GL calls in GLCall; what it adds depends on GL_DEBUG_LEVEL (GLDebug.h).
+// Above OFF it expands to several statements, so brace it under if/else.
+#if GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_TRACE
+	#define GLCall(x) GLDebug::RecordCall(#x, __FILE__, __LINE__);\
+		GLClearError();\
+		x;\
+		ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#elif GL_DEBUG_LEVEL >= GL_DEBUG_LEVEL_ERRORS
+	#define GLCall(x) GLClearError();\
+		x;\
+		ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#else
+	#define GLCall(x) x
+#endif
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
 
+struct RenderStats
+{
+	unsigned int drawCalls = 0;
+	unsigned int shaderChanges = 0;
+	unsigned int vertexArrayChanges = 0;
+	unsigned int textureChanges = 0;
+};
+
 class Renderer
 {
 private:
-
+	RenderQueue m_Queue;
+	RenderStats m_Stats;
+	std::unique_ptr<StreamBuffer> m_StreamBuffer;
 public:
+	Renderer(unsigned int streamBufferFrameSize = 32 * 1024 * 1024);
+	~Renderer();
+
+	// Bracket each frame; they rotate and fence the shared stream buffer
+	void BeginFrame();
+	void EndFrame();
+
+	// Immediate draw, bypasses the queue
 	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
 	void Clear() const;
-	
+
+	// Queued draws: packets are sorted by state and issued on Flush
+	void Submit(const DrawPacket& packet);
+	void Flush();
+
+	inline const RenderStats& GetStats() const { return m_Stats; }
+	// Per-frame ring shared by everything that streams data to the GPU
+	inline StreamBuffer& GetStreamBuffer() { return *m_StreamBuffer; }
 };
\ No newline at end of file
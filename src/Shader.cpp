@@ -1,155 +1,670 @@
 #include "Shader.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
+#include <chrono>
+#include <thread>
 
 #include "Renderer.h"
+#include "GLState.h"
+#include "UniformBuffer.h"
+#include "ShaderCache.h"
+#include "ShaderPreprocessor.h"
+
+static double NowMilliseconds()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Whether source uses name (up to any "[i]" or ".member") as a whole identifier
+static bool ContainsIdentifier(const std::string& source, const char* name)
+{
+	const std::string identifier(name, std::strcspn(name, "[."));
+	if (identifier.empty())
+		return false;
+	auto isIdentifierChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	for (size_t at = source.find(identifier); at != std::string::npos; at = source.find(identifier, at + 1))
+	{
+		const size_t end = at + identifier.size();
+		if ((at == 0 || !isIdentifierChar(source[at - 1])) && (end == source.size() || !isIdentifierChar(source[end])))
+			return true;
+	}
+	return false;
+}
 
 Shader::Shader(const std::string& filepath)
-	: m_FilePath(filepath), m_RendererID(0)
+	: m_FilePath(filepath), m_Current(0), m_ReloadFailed(false)
 {
-	ShaderProgramSource source = ParseShader(filepath);
-	m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+	// Errors are reported here; what did get through still compiles (and fails) as usual
+	ShaderPreprocessor::Process(filepath, m_Source);
+	m_Keywords = m_Source.Keywords;
+	if (m_Keywords.size() > MaxKeywords)
+	{
+		std::cout << "Warning: " << filepath << " declares more than " << MaxKeywords << " keywords" << std::endl;
+		m_Keywords.resize(MaxKeywords);
+	}
+
+	// Only submitted: the keyword-less variant completes on first use or in FinishBuilds
+	Variant variant;
+	variant.build = BeginBuild(m_Source);
+	m_Variants.push_back(variant);
 }
 
 Shader::~Shader() 
 {
-	GLCall(glDeleteProgram(m_RendererID));
+	for (Variant& variant : m_Variants)
+	{
+		DiscardBuild(variant.build);
+		DiscardBuild(variant.reload);
+		GLCall(glDeleteProgram(variant.program));
+		GLState::OnProgramDeleted(variant.program);
+	}
 }
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+unsigned int Shader::CompileShader(unsigned int type, const std::string& source) const
 {
-	std::ifstream stream(filepath);
+	// Only queued; the status is checked once the program has linked
+	GLCall(unsigned int id = glCreateShader(type));
+	const char* src = source.c_str();
+	GLCall(glShaderSource(id, 1, &src, nullptr));
+	GLCall(glCompileShader(id));
+	return id;
+}
 
-	enum class ShaderType
+bool Shader::IsParallelCompileSupported()
+{
+	static const bool supported = []()
 	{
-		NONE = -1,
-		VERTEX = 0,
-		FRAGMENT = 1
-	};
+		if (GLEW_KHR_parallel_shader_compile)
+		{
+			// Let the driver pick the thread count
+			GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu));
+			return true;
+		}
+		if (GLEW_ARB_parallel_shader_compile)
+		{
+			GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFFu));
+			return true;
+		}
+		return false;
+	}();
+	return supported;
+}
+
+Shader::Build Shader::BeginBuild(const ShaderProgramSource& source) const
+{
+	Build build;
+	build.startTime = NowMilliseconds();
+	IsParallelCompileSupported();
+
+	GLCall(build.program = glCreateProgram());
+	build.files = source.Files;
 
-	std::string line;
-	std::stringstream ss[2];
-	ShaderType type = ShaderType::NONE;
+	// A cached binary skips compiling and linking entirely
+	build.cacheKey = ShaderCache::MakeKey(source.VertexSource, source.FragmentSource);
+	if (ShaderCache::Load(build.cacheKey, build.program))
+	{
+		build.fromCache = true;
+		return build;
+	}
+
+	build.vertexShader = CompileShader(GL_VERTEX_SHADER, source.VertexSource);
+	build.fragmentShader = CompileShader(GL_FRAGMENT_SHADER, source.FragmentSource);
+
+	GLCall(glAttachShader(build.program, build.vertexShader));
+	GLCall(glAttachShader(build.program, build.fragmentShader));
+	if (ShaderCache::IsSupported())
+	{
+		GLCall(glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	}
+	GLCall(glLinkProgram(build.program));
+	return build;
+}
+
+bool Shader::IsBuildComplete(const Build& build) const
+{
+	// Without the extension, status queries simply block until the link is done
+	if (build.fromCache || !IsParallelCompileSupported())
+		return true;
+
+	int complete = GL_TRUE;
+	GLCall(glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &complete));
+	return complete == GL_TRUE;
+}
 
-	while (getline(stream, line))
+bool Shader::FinishBuild(Build& build) const
+{
+	int linked = GL_TRUE;
+	if (!build.fromCache)
 	{
-		if (line.find("#shader") != std::string::npos)
+		GLCall(glGetProgramiv(build.program, GL_LINK_STATUS, &linked));
+		if (linked == GL_TRUE)
 		{
-			if (line.find("vertex") != std::string::npos)
-				type = ShaderType::VERTEX;
-			else if (line.find("fragment") != std::string::npos)
-				type = ShaderType::FRAGMENT;
+			ShaderCache::Store(build.cacheKey, build.program);
 		}
 		else
 		{
-			ss[(int)type] << line << '\n';
+			// The stage logs say more than the link log when a stage didn't compile
+			const unsigned int stages[] = { build.vertexShader, build.fragmentShader };
+			for (unsigned int stage : stages)
+			{
+				int compiled = GL_TRUE;
+				GLCall(glGetShaderiv(stage, GL_COMPILE_STATUS, &compiled));
+				if (compiled == GL_TRUE)
+					continue;
+
+				int length = 0;
+				GLCall(glGetShaderiv(stage, GL_INFO_LOG_LENGTH, &length));
+				std::string message(length > 0 ? length : 1, '\0');
+				GLCall(glGetShaderInfoLog(stage, length, nullptr, &message[0]));
+				std::cout << "Failed to compile " << (stage == build.vertexShader ? "vertex" : "fragment")
+					<< " shader of " << m_FilePath << std::endl;
+				std::cout << ShaderPreprocessor::MapLog(message.c_str(), build.files) << std::endl;
+			}
+
+			int length = 0;
+			GLCall(glGetProgramiv(build.program, GL_INFO_LOG_LENGTH, &length));
+			std::string message(length > 0 ? length : 1, '\0');
+			GLCall(glGetProgramInfoLog(build.program, length, nullptr, &message[0]));
+			std::cout << "Failed to link " << m_FilePath << std::endl;
+			std::cout << ShaderPreprocessor::MapLog(message.c_str(), build.files) << std::endl;
 		}
 	}
 
-	return { ss[0].str(), ss[1].str() };
+	if (linked != GL_TRUE)
+	{
+		DiscardBuild(build);
+		return false;
+	}
+
+	// The linked program keeps what it needs from the stages
+	const unsigned int program = build.program;
+	build.program = 0;
+	DiscardBuild(build);
+	build.program = program;
+
+	// Block bindings are program state, but not part of a cached binary
+	BindUniformBlocks(program);
+	return true;
 }
 
-unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+void Shader::DiscardBuild(Build& build) const
 {
-	unsigned int id = glCreateShader(type);
-	const char* src = source.c_str();
-	GLCall(glShaderSource(id, 1, &src, nullptr));
-	GLCall(glCompileShader(id));
+	if (build.vertexShader)
+	{
+		GLCall(glDeleteShader(build.vertexShader));
+	}
+	if (build.fragmentShader)
+	{
+		GLCall(glDeleteShader(build.fragmentShader));
+	}
+	if (build.program)
+	{
+		GLCall(glDeleteProgram(build.program));
+	}
+	build.program = build.vertexShader = build.fragmentShader = 0;
+}
 
-	int result;
-	GLCall(glGetShaderiv(id, GL_COMPILE_STATUS, &result));
+ShaderProgramSource Shader::GetVariantSource(unsigned int keywords) const
+{
+	if (keywords == 0)
+		return m_Source;
 
-	if (result == GL_FALSE)
+	std::string defines;
+	for (unsigned int i = 0; i < m_Keywords.size(); i++)
 	{
-		int lenght;
-		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &lenght);
-#ifdef _WIN32
-		char* message = (char*)_malloca(lenght * sizeof(char));
-#else
-		char* message = (char*)malloc(lenght * sizeof(char));
-#endif
-		glGetShaderInfoLog(id, lenght, &lenght, message);
-		std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << " shader" << std::endl;
-		std::cout << message << std::endl;
-#ifndef _WIN32
-		free(message);
-#endif
-		glDeleteShader(id);
-		return 0;
+		if (keywords & (1u << i))
+			defines += "#define " + m_Keywords[i] + " 1\n";
 	}
 
-	return id;
+	// #version has to stay first. The preprocessor follows it with a #line,
+	// so the defines don't shift the line numbers in compiler messages.
+	auto inject = [&defines](const std::string& source)
+	{
+		size_t insert = 0;
+		const size_t version = source.find("#version");
+		if (version != std::string::npos)
+		{
+			const size_t end = source.find('\n', version);
+			insert = end == std::string::npos ? source.size() : end + 1;
+		}
+		std::string result = source.substr(0, insert);
+		if (insert == source.size() && (result.empty() || result.back() != '\n'))
+			result += '\n';
+		result += defines;
+		result.append(source, insert, std::string::npos);
+		return result;
+	};
+
+	// Files and keywords as the base program's, so MapLog names the files
+	ShaderProgramSource source = m_Source;
+	source.VertexSource = inject(m_Source.VertexSource);
+	source.FragmentSource = inject(m_Source.FragmentSource);
+	return source;
 }
 
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+unsigned int Shader::GetVariant(unsigned int keywords) const
 {
-	unsigned int program = glCreateProgram();
-	unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-	unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+	keywords &= m_Keywords.size() >= 32 ? ~0u : (1u << m_Keywords.size()) - 1;
+	for (unsigned int i = 0; i < m_Variants.size(); i++)
+	{
+		if (m_Variants[i].keywords == keywords)
+		{
+			if (m_Variants[i].build.program)
+				CompleteVariant(m_Variants[i]);
+			return i;
+		}
+	}
 
-	GLCall(glAttachShader(program, vs));
-	GLCall(glAttachShader(program, fs));
-	GLCall(glLinkProgram(program));
-	GLCall(glValidateProgram(program));
+	Variant variant;
+	variant.keywords = keywords;
+	variant.build = BeginBuild(GetVariantSource(keywords));
+	m_Variants.push_back(variant);
+	CompleteVariant(m_Variants.back());
+	return static_cast<unsigned int>(m_Variants.size() - 1);
+}
 
-	GLCall(glDeleteShader(vs));
-	GLCall(glDeleteShader(fs));
+void Shader::CompleteVariant(Variant& variant) const
+{
+	Build build = variant.build;
+	variant.build = Build();
+	const bool linked = FinishBuild(build);
+	ShaderCache::RecordProgram(build.fromCache, NowMilliseconds() - build.startTime);
 
-	return program;
+	// A failed variant keeps program 0 and draws nothing
+	variant.program = linked ? build.program : 0;
+	variant.locations.assign(m_Uniforms.size(), -1);
+	variant.values.resize(m_Uniforms.size());
+	if (linked)
+		ReflectUniforms(variant);
 }
 
-void Shader::Bind() const
+void Shader::FinishBuilds(const std::vector<const Shader*>& shaders)
 {
-	GLCall(glUseProgram(m_RendererID));
+	for (;;)
+	{
+		bool pending = false;
+		for (const Shader* shader : shaders)
+		{
+			for (Variant& variant : shader->m_Variants)
+			{
+				if (!variant.build.program)
+					continue;
+				if (shader->IsBuildComplete(variant.build))
+					shader->CompleteVariant(variant);
+				else
+					pending = true;
+			}
+		}
+		if (!pending)
+			return;
+		std::this_thread::yield();
+	}
+}
+
+unsigned int Shader::GetRendererID(unsigned int variant) const
+{
+	return m_Variants[GetVariant(variant)].program;
+}
+
+unsigned int Shader::GetKeyword(const char* keyword) const
+{
+	for (unsigned int i = 0; i < m_Keywords.size(); i++)
+	{
+		if (m_Keywords[i] == keyword)
+			return 1u << i;
+	}
+	std::cout << "Warning: keyword '" << keyword << "' isn't declared in " << m_FilePath << "!" << std::endl;
+	return 0;
+}
+
+void Shader::Reload()
+{
+	ShaderProgramSource source;
+	if (!ShaderPreprocessor::Process(m_FilePath, source))
+	{
+		// Nothing worth compiling; the current programs stay
+		for (Variant& variant : m_Variants)
+			DiscardBuild(variant.reload);
+		m_ReloadFailed = true;
+		return;
+	}
+	if (source.Keywords != m_Source.Keywords)
+		std::cout << "Warning: keywords of " << m_FilePath << " changed; variant bits keep the old meaning until restart" << std::endl;
+	m_Source = source;
+	m_ReloadFailed = false;
+
+	for (Variant& variant : m_Variants)
+	{
+		// A first build still in flight is simply resubmitted with the new source
+		Build& build = variant.build.program ? variant.build : variant.reload;
+		DiscardBuild(build);
+		build = BeginBuild(GetVariantSource(variant.keywords));
+	}
+}
+
+ShaderReloadStatus Shader::PollReload()
+{
+	bool pending = false, finished = false;
+	for (Variant& variant : m_Variants)
+	{
+		if (!variant.reload.program)
+			continue;
+		if (!IsBuildComplete(variant.reload))
+		{
+			pending = true;
+			continue;
+		}
+
+		Build build = variant.reload;
+		variant.reload = Build();
+		finished = true;
+		if (!FinishBuild(build))
+		{
+			m_ReloadFailed = true;
+			continue;
+		}
+
+		// Swap: anything drawing with this variant picks the new program up on its next Bind
+		GLCall(glDeleteProgram(variant.program));
+		GLState::OnProgramDeleted(variant.program);
+		variant.program = build.program;
+		ReflectUniforms(variant);
+		RestoreUniformValues(variant);
+	}
+
+	if (pending)
+		return ShaderReloadStatus::Pending;
+	if (!finished && !m_ReloadFailed)
+		return ShaderReloadStatus::Idle;
+
+	// Reported once per reload
+	const bool failed = m_ReloadFailed;
+	m_ReloadFailed = false;
+	return failed ? ShaderReloadStatus::Failed : ShaderReloadStatus::Swapped;
+}
+
+bool Shader::IsReloading() const
+{
+	for (const Variant& variant : m_Variants)
+	{
+		if (variant.reload.program)
+			return true;
+	}
+	return false;
+}
+
+void Shader::BindUniformBlocks(unsigned int program) const
+{
+	// GLSL 330 has no layout(binding = N), so shared blocks are bound by name
+	for (const UniformBlockBinding& block : UNIFORM_BLOCKS)
+	{
+		GLCall(unsigned int index = glGetUniformBlockIndex(program, block.name));
+		if (index != GL_INVALID_INDEX)
+		{
+			GLCall(glUniformBlockBinding(program, index, block.binding));
+		}
+	}
+}
+
+
+void Shader::Bind(unsigned int variant) const
+{
+	m_Current = GetVariant(variant);
+	GLState::UseProgram(m_Variants[m_Current].program);
 }
 
 void Shader::Unbind() const
 {
-	GLCall(glUseProgram(0));
+	GLState::UseProgram(0);
+}
+
+int Shader::AddUniform(const std::string& name, std::uint32_t hash) const
+{
+	UniformInfo info;
+	info.name = name;
+	info.hash = hash;
+	info.type = 0;
+	info.count = 0;
+	m_Uniforms.push_back(info);
+	for (Variant& variant : m_Variants)
+	{
+		variant.locations.push_back(-1);
+		variant.values.push_back(UniformValue());
+	}
+
+	const int index = static_cast<int>(m_Uniforms.size() - 1);
+	const std::pair<std::uint32_t, int> entry(hash, index);
+	m_UniformLookup.insert(std::upper_bound(m_UniformLookup.begin(), m_UniformLookup.end(), entry), entry);
+	return index;
+}
+
+void Shader::ReflectUniforms(Variant& variant) const
+{
+	// Table entries keep their index, so handles survive a reload; a
+	// uniform the new program lacks just loses its location
+	variant.locations.assign(m_Uniforms.size(), -1);
+	variant.values.resize(m_Uniforms.size());
+
+	int count = 0, maxLength = 0;
+	GLCall(glGetProgramiv(variant.program, GL_ACTIVE_UNIFORMS, &count));
+	GLCall(glGetProgramiv(variant.program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+
+	std::string buffer(maxLength > 0 ? maxLength : 1, '\0');
+	for (int i = 0; i < count; i++)
+	{
+		int length = 0, size = 0;
+		unsigned int type = 0;
+		GLCall(glGetActiveUniform(variant.program, i, maxLength, &length, &size, &type, &buffer[0]));
+
+		std::string name(buffer.c_str(), length);
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			name.resize(name.size() - 3);
+
+		// Members of uniform blocks have no location; they are set through the block
+		GLCall(int location = glGetUniformLocation(variant.program, name.c_str()));
+		if (location == -1)
+			continue;
+
+		UniformHandle handle = FindUniform(name.c_str());
+		const int index = handle.IsValid() ? handle.index : AddUniform(name, HashUniformName(name.c_str()));
+
+		// A changed type makes the remembered value meaningless
+		UniformInfo& info = m_Uniforms[index];
+		if (info.type != type)
+			variant.values[index].size = 0;
+		info.type = type;
+		info.count = size;
+		variant.locations[index] = location;
+	}
+}
+
+void Shader::RestoreUniformValues(const Variant& variant) const
+{
+	// A new program starts with default values; re-send what the old one had
+	GLState::UseProgram(variant.program);
+	for (size_t i = 0; i < m_Uniforms.size(); i++)
+	{
+		const int location = variant.locations[i];
+		const UniformValue& value = variant.values[i];
+		if (location == -1 || value.size == 0)
+			continue;
+
+		const float* f = reinterpret_cast<const float*>(value.bytes);
+		const int* n = reinterpret_cast<const int*>(value.bytes);
+		switch (value.size)
+		{
+		case sizeof(float):
+			if (m_Uniforms[i].type == GL_FLOAT)
+			{
+				GLCall(glUniform1f(location, f[0]));
+			}
+			else
+			{
+				GLCall(glUniform1i(location, n[0]));
+			}
+			break;
+		case 3 * sizeof(float):
+			GLCall(glUniform3fv(location, 1, f));
+			break;
+		case 4 * sizeof(float):
+			GLCall(glUniform4fv(location, 1, f));
+			break;
+		case sizeof(glm::mat4):
+			GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, f));
+			break;
+		}
+	}
+}
+
+UniformHandle Shader::FindUniform(UniformName name) const
+{
+	// The table is filled when the keyword-less variant is reflected
+	if (m_Variants[0].build.program)
+		CompleteVariant(m_Variants[0]);
+
+	auto it = std::lower_bound(m_UniformLookup.begin(), m_UniformLookup.end(), name.hash,
+		[](const std::pair<std::uint32_t, int>& entry, std::uint32_t hash) { return entry.first < hash; });
+
+	// Compare the names too, so a hash collision can't hand out the wrong uniform
+	for (; it != m_UniformLookup.end() && it->first == name.hash; ++it)
+	{
+		if (m_Uniforms[it->second].name == name.name)
+		{
+			UniformHandle handle;
+			handle.index = it->second;
+			return handle;
+		}
+	}
+	return UniformHandle();
+}
+
+UniformHandle Shader::GetUniform(UniformName name) const
+{
+	UniformHandle handle = FindUniform(name);
+	if (handle.IsValid())
+		return handle;
+
+	// May live in a variant that hasn't been compiled yet, if the source has it at all
+	if (!m_Keywords.empty() &&
+		(ContainsIdentifier(m_Source.VertexSource, name.name) || ContainsIdentifier(m_Source.FragmentSource, name.name)))
+	{
+		handle.index = AddUniform(name.name, name.hash);
+		return handle;
+	}
+
+	if (std::find(m_ReportedMissing.begin(), m_ReportedMissing.end(), name.hash) == m_ReportedMissing.end())
+	{
+		std::cout << "Warning: uniform '" << name.name << "' doesn't exist in " << m_FilePath << "!" << std::endl;
+		m_ReportedMissing.push_back(name.hash);
+	}
+	return handle;
+}
+
+bool Shader::HasUniform(const std::string& name) const
+{
+	UniformHandle handle = FindUniform(name.c_str());
+	return handle.IsValid() && m_Variants[m_Current].locations[handle.index] != -1;
+}
+
+int Shader::GetUniformLocation(UniformHandle uniform) const
+{
+	return uniform.IsValid() ? m_Variants[m_Current].locations[uniform.index] : -1;
+}
+
+bool Shader::UpdateShadow(UniformHandle uniform, const void* value, size_t size) const
+{
+	if (GetUniformLocation(uniform) == -1)
+		return false;
+
+	UniformValue& shadow = m_Variants[m_Current].values[uniform.index];
+	if (shadow.size == size && std::memcmp(shadow.bytes, value, size) == 0)
+	{
+		GLState::CountUniform(false);
+		return false;
+	}
+	std::memcpy(shadow.bytes, value, size);
+	shadow.size = static_cast<unsigned char>(size);
+	GLState::CountUniform(true);
+	return true;
+}
+
+void Shader::SetUniform1i(UniformHandle uniform, int value) const
+{
+	if (UpdateShadow(uniform, &value, sizeof(value)))
+	{
+		GLCall(glUniform1i(GetUniformLocation(uniform), value));
+	}
+}
+
+void Shader::SetUniform1f(UniformHandle uniform, float value) const
+{
+	if (UpdateShadow(uniform, &value, sizeof(value)))
+	{
+		GLCall(glUniform1f(GetUniformLocation(uniform), value));
+	}
+}
+
+void Shader::SetUniform3f(UniformHandle uniform, float v0, float v1, float v2) const
+{
+	const float value[3] = { v0, v1, v2 };
+	if (UpdateShadow(uniform, value, sizeof(value)))
+	{
+		GLCall(glUniform3f(GetUniformLocation(uniform), v0, v1, v2));
+	}
+}
+
+void Shader::SetUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3) const
+{
+	const float value[4] = { v0, v1, v2, v3 };
+	if (UpdateShadow(uniform, value, sizeof(value)))
+	{
+		GLCall(glUniform4f(GetUniformLocation(uniform), v0, v1, v2, v3));
+	}
+}
+
+void Shader::SetUniformMat4f(UniformHandle uniform, const glm::mat4& matrix) const
+{
+	if (UpdateShadow(uniform, &matrix[0][0], sizeof(glm::mat4)))
+	{
+		GLCall(glUniformMatrix4fv(GetUniformLocation(uniform), 1, GL_FALSE, &matrix[0][0]));
+	}
+}
+
+void Shader::SetUniformBool(UniformHandle uniform, bool value) const
+{
+	SetUniform1i(uniform, value ? 1 : 0);
 }
 
 void Shader::SetUniform1i(const std::string& name, int value) const
 {
-	GLCall(glUniform1i(GetUniformLocation(name), value));
+	SetUniform1i(GetUniform(name.c_str()), value);
 }
 
 void Shader::SetUniform1f(const std::string& name, float value) const
 {
-	GLCall(glUniform1f(GetUniformLocation(name), value));
+	SetUniform1f(GetUniform(name.c_str()), value);
 }
 
 void Shader::SetUniform3f(const std::string& name, float v0, float v1, float v2) const
 {
-	GLCall(glUniform3f(GetUniformLocation(name), v0, v1, v2));
+	SetUniform3f(GetUniform(name.c_str()), v0, v1, v2);
 }
 
 void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3) const
 {
-	GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
+	SetUniform4f(GetUniform(name.c_str()), v0, v1, v2, v3);
 }
 
 void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix) const
 {
-	GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
+	SetUniformMat4f(GetUniform(name.c_str()), matrix);
 }
 
 void Shader::SetUniformBool(const std::string& name, bool value) const
 {
-	GLCall(glUniform1i(GetUniformLocation(name), value ? 1 : 0));
+	SetUniformBool(GetUniform(name.c_str()), value);
 }
-
-int Shader::GetUniformLocation(const std::string& name) const
-{
-	if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
-		return m_UniformLocationCache[name];
-
-	GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
-	if (location == -1)
-		std::cout << "Warning: uniform '" << name << "' doesn't exist!" << std::endl;
-
-	m_UniformLocationCache[name] = location;
-	return location;
-}
\ No newline at end of file
@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "glm/glm.hpp"
 
@@ -9,23 +10,190 @@ struct ShaderProgramSource
 {
 	std::string VertexSource;
 	std::string FragmentSource;
+	std::vector<std::string> Keywords;
+	std::vector<std::string> Files;		// [0] the .shader file, then its includes; numbered as in #line
 };
 
+// 32-bit FNV-1a of a uniform name. constexpr, so names written as literals
+// are hashed by the compiler.
+constexpr std::uint32_t HashUniformName(const char* name)
+{
+	std::uint32_t hash = 2166136261u;
+	for (; *name; ++name)
+	{
+		hash ^= static_cast<unsigned char>(*name);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// A uniform name with its precomputed hash. Declare the ones a call site
+// uses as constants, e.g. static constexpr UniformName U_COLOR("u_Color");
+struct UniformName
+{
+	const char* name;
+	std::uint32_t hash;
+
+	constexpr UniformName(const char* uniformName)
+		: name(uniformName), hash(HashUniformName(uniformName)) {}
+};
+
+// A uniform seen in any variant of the program, as reported by
+// glGetActiveUniform after linking. Locations are per variant.
+struct UniformInfo
+{
+	std::string name;			// without the "[0]" GL appends to arrays
+	std::uint32_t hash;
+	unsigned int type;			// GL_FLOAT_VEC3, GL_SAMPLER_2D, ...; 0 until a variant declares it
+	int count;					// array size, 1 for non-arrays
+};
+
+// Index into one Shader's uniform table. Resolve once (GetUniform), then
+// set through it every frame: no string, no hashing, no lookup. A handle
+// is only meaningful for the shader that returned it; it works with every
+// variant and stays valid across hot reloads.
+struct UniformHandle
+{
+	int index = -1;
+
+	inline bool IsValid() const { return index >= 0; }
+};
+
+enum class ShaderReloadStatus
+{
+	Idle,			// no reload in flight
+	Pending,		// still compiling / linking
+	Swapped,		// the new programs are in use
+	Failed			// a build failed; that variant keeps its previous program
+};
+
+// A program loaded from a .shader file, with optional keyword variants.
+//
+// A file may declare feature keywords on a line before the first stage:
+//
+//	#keywords USE_TEXTURE USE_FOG
+//
+// (see ShaderPreprocessor for the file format and #include).
+// Each combination is a variant, identified by a bitmask of GetKeyword()
+// bits, and compiled the first time it is bound, with "#define KEYWORD 1"
+// inserted after each stage's #version line. Features are then chosen with
+// #ifdef at compile time instead of branching on a uniform per fragment.
+// Variant 0 (no keywords) is submitted by the constructor.
+//
+// Building never blocks until a program is needed: the constructor only
+// queues the compile and link, and the first Bind (or uniform lookup)
+// waits for it. To load several shaders at once, construct them all, do
+// other loading work, then call FinishBuilds, which completes them in
+// whatever order the driver finishes them.
 class Shader
 {
+public:
+	static constexpr unsigned int MaxKeywords = 32;
 
 private:
+	// Last value sent for a uniform, as raw bytes (up to a mat4)
+	struct UniformValue
+	{
+		unsigned char bytes[64];
+		unsigned char size = 0;		// 0 until the first set; link-time values aren't tracked
+	};
+
+	// A program on its way from source to linked; compile and link are
+	// only queued until FinishBuild
+	struct Build
+	{
+		unsigned int program = 0;
+		unsigned int vertexShader = 0;
+		unsigned int fragmentShader = 0;
+		std::string cacheKey;
+		std::vector<std::string> files;	// to map compiler logs back to paths
+		bool fromCache = false;
+		double startTime = 0.0;		// ms, for the startup report
+	};
+
+	struct Variant
+	{
+		unsigned int keywords = 0;
+		unsigned int program = 0;
+		std::vector<int> locations;			// by handle index, -1 where this variant lacks the uniform
+		std::vector<UniformValue> values;	// by handle index
+		Build build;						// first build, program == 0 once finished
+		Build reload;						// program == 0 if no reload in flight
+	};
+
 	std::string m_FilePath;
-	unsigned int m_RendererID;
-	mutable std::unordered_map<std::string, int> m_UniformLocationCache;
+	ShaderProgramSource m_Source;						// as preprocessed, without keyword defines
+	std::vector<std::string> m_Keywords;				// bit i is m_Keywords[i]
+	// Variants are built lazily from const paths (Bind, GetRendererID), so
+	// everything they touch is mutable
+	mutable std::vector<UniformInfo> m_Uniforms;		// in handle order; only grows
+	mutable std::vector<std::pair<std::uint32_t, int>> m_UniformLookup;	// (hash, index), sorted
+	mutable std::vector<Variant> m_Variants;			// [0] is the keyword-less variant
+	mutable unsigned int m_Current;						// variant the setters apply to
+	mutable std::vector<std::uint32_t> m_ReportedMissing;	// unknown names already warned about
+	bool m_ReloadFailed;								// some variant of the current reload failed
 public:
 	Shader(const std::string& filepath);
 	~Shader();
 
-	void Bind() const;
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	// Binds the given variant, compiling it on first use. The SetUniform*
+	// calls that follow apply to it.
+	void Bind(unsigned int variant = 0) const;
 	void Unbind() const;
 
-	//Set Uniforms
+	unsigned int GetRendererID(unsigned int variant = 0) const;
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	// The .shader file and every file it includes, as of the last (re)load
+	inline const std::vector<std::string>& GetSourceFiles() const { return m_Source.Files; }
+	inline const std::vector<UniformInfo>& GetUniforms() const { return m_Uniforms; }
+
+	// Variant bit of a keyword declared with #keywords; 0 (and a warning)
+	// for names the file doesn't declare
+	unsigned int GetKeyword(const char* keyword) const;
+	inline const std::vector<std::string>& GetKeywords() const { return m_Keywords; }
+	inline unsigned int GetVariantCount() const { return static_cast<unsigned int>(m_Variants.size()); }
+
+	// Hot reload: re-reads the files and queues the compile of every variant
+	// built so far, without waiting for it (restarting a reload already in
+	// flight). PollReload swaps each new program in once it has linked.
+	// Uniform handles stay valid and the values set so far are re-sent to
+	// the new programs; a variant whose build fails keeps its program.
+	void Reload();
+	ShaderReloadStatus PollReload();
+	bool IsReloading() const;
+
+	// KHR/ARB_parallel_shader_compile: compiles run on driver threads and
+	// completion can be polled without blocking
+	static bool IsParallelCompileSupported();
+
+	// Waits for the submitted builds of all the given shaders, finishing
+	// each one as soon as the driver reports it done, so the wait is as long
+	// as the slowest program rather than the sum of them
+	static void FinishBuilds(const std::vector<const Shader*>& shaders);
+
+	// Resolves a uniform; warns once if no variant can have a uniform of
+	// that name (misspelled, or optimized out). With keywords, a name not
+	// seen yet may belong to a variant not compiled yet, so it is accepted.
+	UniformHandle GetUniform(UniformName name) const;
+	// As GetUniform, but never warns and never adds names
+	UniformHandle FindUniform(UniformName name) const;
+	// True if the program has an active uniform with this name (never warns)
+	bool HasUniform(const std::string& name) const;
+
+	// Set Uniforms on the bound variant. Each program keeps a shadow copy of
+	// the values it was sent, and a set that would not change anything skips
+	// the glUniform call; the program must be bound, as for any glUniform.
+	void SetUniform1i(UniformHandle uniform, int value) const;
+	void SetUniform1f(UniformHandle uniform, float value) const;
+	void SetUniform3f(UniformHandle uniform, float v0, float v1, float v2) const;
+	void SetUniform4f(UniformHandle uniform, float v0, float v1, float v2, float v3) const;
+	void SetUniformMat4f(UniformHandle uniform, const glm::mat4& matrix) const;
+	void SetUniformBool(UniformHandle uniform, bool value) const;
+
+	// By name: resolves on every call, for one-off and setup code
 	void SetUniform1i(const std::string& name, int value) const;
 	void SetUniform1f(const std::string& name, float value) const;
 	void SetUniform3f(const std::string& name, float v0, float v1, float v2) const;
@@ -34,9 +202,25 @@ public:
 	void SetUniformBool(const std::string& name, bool value) const;
 
 private:
-	ShaderProgramSource ParseShader(const std::string& filepath);
-	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	unsigned int CompileShader(unsigned int type, const std::string& source) const;
+	ShaderProgramSource GetVariantSource(unsigned int keywords) const;
+	Build BeginBuild(const ShaderProgramSource& source) const;
+	bool IsBuildComplete(const Build& build) const;
+	// Waits for the build if needed; on failure logs why and deletes the program
+	bool FinishBuild(Build& build) const;
+	void DiscardBuild(Build& build) const;
+	void BindUniformBlocks(unsigned int program) const;
+
+	// Index into m_Variants, building the variant if it doesn't exist yet
+	// and waiting for it if it is still being built
+	unsigned int GetVariant(unsigned int keywords) const;
+	void CompleteVariant(Variant& variant) const;
+	void ReflectUniforms(Variant& variant) const;
+	void RestoreUniformValues(const Variant& variant) const;
+	int AddUniform(const std::string& name, std::uint32_t hash) const;
 
-	int GetUniformLocation(const std::string& name) const;
-};
\ No newline at end of file
+	int GetUniformLocation(UniformHandle uniform) const;
+	// Records the value for the bound variant and returns true if it
+	// differs from the shadow copy
+	bool UpdateShadow(UniformHandle uniform, const void* value, size_t size) const;
+};
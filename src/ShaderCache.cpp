@@ -0,0 +1,241 @@
+#include "ShaderCache.h"
+
+#include "Renderer.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+	struct CacheFileHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t hash;
+		std::uint32_t format;		// GLenum from glGetProgramBinary
+		std::uint32_t length;		// bytes of binary following the header
+	};
+
+	constexpr char CacheMagic[4] = { 'O', 'G', 'T', 'B' };
+	// Bump when the header or the key inputs change
+	constexpr std::uint32_t CacheVersion = 1;
+	// Anything larger is a corrupt header, not a program
+	constexpr std::uint32_t MaxBinaryLength = 64 * 1024 * 1024;
+
+	ShaderCacheStats s_Stats;
+
+	std::uint64_t Fnv1a(std::uint64_t hash, const char* data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<unsigned char>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::uint64_t Fnv1a(std::uint64_t hash, const char* text)
+	{
+		// The terminator goes in too, so ("ab", "c") and ("a", "bc") differ
+		return Fnv1a(hash, text ? text : "", std::strlen(text ? text : "") + 1);
+	}
+
+	std::string CachePath(const std::string& key)
+	{
+		return std::string(ShaderCache::Directory) + "/" + key + ".bin";
+	}
+
+	// Removes the oldest entries past MaxEntries, least recently used
+	// first (Load refreshes an entry's time). Each edit of a shader
+	// under hot reload stores a new entry and nothing reads the old one again
+	void Trim()
+	{
+		struct Entry
+		{
+			std::filesystem::path path;
+			std::filesystem::file_time_type time;
+		};
+		std::vector<Entry> entries;
+		std::error_code error;
+		for (auto it = std::filesystem::directory_iterator(ShaderCache::Directory, error);
+			!error && it != std::filesystem::directory_iterator(); it.increment(error))
+		{
+			if (it->path().extension() != ".bin")
+				continue;
+			const auto time = it->last_write_time(error);
+			if (!error)
+				entries.push_back({ it->path(), time });
+		}
+		if (error || entries.size() <= ShaderCache::MaxEntries)
+			return;
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+		for (size_t i = 0; i + ShaderCache::MaxEntries < entries.size(); i++)
+			std::filesystem::remove(entries[i].path, error);
+	}
+
+	bool IsFormatSupported(GLenum format)
+	{
+		GLint count = 0;
+		GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+		std::vector<GLint> formats(count);
+		if (count > 0)
+		{
+			GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+		}
+		for (GLint supported : formats)
+		{
+			if (static_cast<GLenum>(supported) == format)
+				return true;
+		}
+		return false;
+	}
+
+}
+
+bool ShaderCache::IsSupported()
+{
+	// One context per run, so the answer never changes
+	static const bool supported = []()
+	{
+		if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+			return false;
+		GLint count = 0;
+		GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+		return count > 0;
+	}();
+	return supported;
+}
+
+std::string ShaderCache::MakeKey(const std::string& vertexSource, const std::string& fragmentSource)
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	hash = Fnv1a(hash, vertexSource.c_str(), vertexSource.size() + 1);
+	hash = Fnv1a(hash, fragmentSource.c_str(), fragmentSource.size() + 1);
+	hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	hash = Fnv1a(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+	char key[17];
+	std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+	return key;
+}
+
+bool ShaderCache::Load(const std::string& key, unsigned int program)
+{
+	if (!IsSupported())
+		return false;
+
+	std::ifstream file(CachePath(key), std::ios::binary);
+	if (!file)
+		return false;
+
+	CacheFileHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+		header.version != CacheVersion ||
+		header.hash != std::stoull(key, nullptr, 16) ||
+		header.length == 0 || header.length > MaxBinaryLength)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), header.length))
+		return false;
+
+	// An unknown format would raise GL_INVALID_ENUM; treat it as a stale entry
+	if (!IsFormatSupported(header.format))
+	{
+		s_Stats.rejected++;
+		return false;
+	}
+
+	GLCall(glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length)));
+	GLint linked = GL_FALSE;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	if (linked != GL_TRUE)
+	{
+		s_Stats.rejected++;
+		return false;
+	}
+
+	// Used entries look new to Trim, which removes the oldest
+	file.close();
+	std::error_code error;
+	std::filesystem::last_write_time(CachePath(key), std::filesystem::file_time_type::clock::now(), error);
+	return true;
+}
+
+void ShaderCache::Store(const std::string& key, unsigned int program)
+{
+	if (!IsSupported())
+		return;
+
+	GLint length = 0;
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (length <= 0 || static_cast<std::uint32_t>(length) > MaxBinaryLength)
+		return;
+
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	GLCall(glGetProgramBinary(program, length, &written, &format, binary.data()));
+	if (written <= 0)
+		return;
+
+	std::error_code error;
+	std::filesystem::create_directories(Directory, error);
+	if (error)
+		return;
+
+	CacheFileHeader header;
+	std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+	header.version = CacheVersion;
+	header.hash = std::stoull(key, nullptr, 16);
+	header.format = format;
+	header.length = static_cast<std::uint32_t>(written);
+
+	// Write to a temporary and rename, so a crash never leaves half an entry
+	const std::string path = CachePath(key);
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), written);
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		std::filesystem::remove(temporary, error);
+		return;
+	}
+	Trim();
+}
+
+void ShaderCache::RecordProgram(bool hit, double milliseconds)
+{
+	if (hit)
+		s_Stats.hits++;
+	else
+		s_Stats.misses++;
+	s_Stats.milliseconds += milliseconds;
+}
+
+const ShaderCacheStats& ShaderCache::GetStats()
+{
+	return s_Stats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+struct ShaderCacheStats
+{
+	unsigned int hits = 0;			// programs restored with glProgramBinary
+	unsigned int misses = 0;		// no usable entry, compiled from source
+	unsigned int rejected = 0;		// entries the driver refused (counted as misses too)
+	double milliseconds = 0.0;		// submit-to-ready time summed over programs (they may overlap)
+};
+
+// On-disk cache of linked program binaries (ARB_get_program_binary).
+//
+// Entries are keyed by a 64-bit FNV-1a hash of the preprocessed stage
+// sources plus the GL vendor, renderer and version strings, so a driver
+// update or a different GPU never sees a stale binary. A blob the driver
+// rejects anyway (binaries are allowed to go stale at any time) is a silent
+// miss: the caller compiles from source and the entry is rewritten.
+//
+// Entries live in shader_cache/ next to res/, one file per program. Past
+// MaxEntries, storing one removes the least recently used, so edits
+// under hot reload (each a new key) don't grow the directory forever.
+class ShaderCache
+{
+public:
+	static constexpr const char* Directory = "shader_cache";
+	// Programs times variants in use, with room for a few edits of each
+	static constexpr size_t MaxEntries = 64;
+
+	// False without program binary support or binary formats
+	static bool IsSupported();
+
+	static std::string MakeKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+	// Tries to restore program (a fresh glCreateProgram name) from the cache.
+	// On true the program is linked and ready to use.
+	static bool Load(const std::string& key, unsigned int program);
+	// Stores a successfully linked program; failures only cost the next start
+	static void Store(const std::string& key, unsigned int program);
+
+	// Totals for the program creations so far, for the startup report
+	static void RecordProgram(bool hit, double milliseconds);
+	static const ShaderCacheStats& GetStats();
+};
@@ -0,0 +1,410 @@
+#include "ShaderPreprocessor.h"
+
+#include "AssetPack.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+	enum class ChunkType
+	{
+		Text,
+		Include,
+		Stage
+	};
+
+	struct Chunk
+	{
+		ChunkType type;
+		unsigned int line;		// 1-based line of the chunk in its file
+		std::string text;		// Text: whole lines, '\n'-terminated; Include: resolved path
+		int stage = -1;			// Stage: 0 vertex, 1 fragment
+	};
+
+	// One scanned file, as kept in the cache
+	struct ParsedFile
+	{
+		std::uintmax_t size = 0;
+		std::filesystem::file_time_type writeTime;
+		std::vector<Chunk> chunks;
+		std::vector<std::string> keywords;
+		std::vector<std::string> errors;	// "file:line: error: ...", reported on every use
+	};
+
+	std::mutex s_CacheMutex;
+	std::unordered_map<std::string, std::shared_ptr<const ParsedFile>> s_Cache;
+	ShaderPreprocessorStats s_Stats;
+
+	std::string NormalizePath(const std::filesystem::path& path)
+	{
+		return path.lexically_normal().generic_string();
+	}
+
+	const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+			p++;
+		return p;
+	}
+
+	std::string ReadWord(const char*& p, const char* end)
+	{
+		const char* start = p;
+		while (p < end && (std::isalnum(static_cast<unsigned char>(*p)) || *p == '_'))
+			p++;
+		return std::string(start, p);
+	}
+
+	ParsedFile Scan(const std::string& path, const char* data, size_t size)
+	{
+		ParsedFile parsed;
+		const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		const size_t NoText = static_cast<size_t>(-1);
+		size_t text = NoText;		// chunk plain lines are appended to
+		bool stageSeen = false;
+
+		auto error = [&](unsigned int line, const std::string& message)
+		{
+			parsed.errors.push_back(path + ":" + std::to_string(line) + ": error: " + message);
+		};
+
+		const char* end = data + size;
+		unsigned int lineNumber = 1;
+		for (const char* line = data; line < end; lineNumber++)
+		{
+			const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+			const char* lineEnd = newline ? newline : end;
+			const char* next = newline ? newline + 1 : end;
+
+			const char* p = SkipBlanks(line, lineEnd);
+			if (p < lineEnd && *p == '#')
+			{
+				p = SkipBlanks(p + 1, lineEnd);
+				const char* arguments = p;
+				const std::string directive = ReadWord(arguments, lineEnd);
+				arguments = SkipBlanks(arguments, lineEnd);
+
+				bool consumed = true;
+				if (directive == "shader")
+				{
+					const std::string stage = ReadWord(arguments, lineEnd);
+					Chunk chunk{ ChunkType::Stage, lineNumber, std::string() };
+					chunk.stage = stage == "vertex" ? 0 : stage == "fragment" ? 1 : -1;
+					if (chunk.stage < 0)
+						error(lineNumber, "unknown stage '" + stage + "'");
+					else
+						parsed.chunks.push_back(chunk);
+					stageSeen = true;
+				}
+				else if (directive == "include")
+				{
+					const char close = arguments < lineEnd && *arguments == '<' ? '>' : '"';
+					const char* nameEnd = arguments < lineEnd && (*arguments == '"' || *arguments == '<')
+						? std::find(arguments + 1, lineEnd, close) : arguments;
+					if (nameEnd == arguments || nameEnd == lineEnd || nameEnd == arguments + 1)
+						error(lineNumber, "expected #include \"file\"");
+					else
+						parsed.chunks.push_back({ ChunkType::Include, lineNumber,
+							NormalizePath(directory / std::string(arguments + 1, nameEnd)) });
+				}
+				else if (directive == "keywords")
+				{
+					if (stageSeen)
+						error(lineNumber, "#keywords must come before the first #shader");
+					for (std::string keyword = ReadWord(arguments, lineEnd); !keyword.empty();
+						arguments = SkipBlanks(arguments, lineEnd), keyword = ReadWord(arguments, lineEnd))
+					{
+						parsed.keywords.push_back(keyword);
+					}
+				}
+				else if (directive == "pragma")
+				{
+					consumed = ReadWord(arguments, lineEnd) == "once";
+				}
+				else
+				{
+					consumed = false;
+				}
+
+				if (consumed)
+				{
+					// The next plain line starts a new chunk, with its own #line
+					text = NoText;
+					line = next;
+					continue;
+				}
+			}
+
+			if (text == NoText)
+			{
+				parsed.chunks.push_back({ ChunkType::Text, lineNumber, std::string() });
+				text = parsed.chunks.size() - 1;
+			}
+			parsed.chunks[text].text.append(line, lineEnd);
+			parsed.chunks[text].text += '\n';
+			line = next;
+		}
+		return parsed;
+	}
+
+	// The scanned file at path (normalized), from the mounted asset pack
+	// or the file, and from the cache while it is current; nullptr if it
+	// can't be read
+	std::shared_ptr<const ParsedFile> Load(const std::string& path)
+	{
+		const AssetPack* pack = AssetPack::GetMounted();
+		size_t packedSize = 0;
+		std::filesystem::file_time_type packedTime;
+		const bool packed = pack && pack->GetStamp(path, packedSize, packedTime);
+
+		std::error_code error;
+		const auto writeTime = packed ? packedTime : std::filesystem::last_write_time(path, error);
+		if (error)
+			return nullptr;
+		const std::uintmax_t size = packed ? packedSize : std::filesystem::file_size(path, error);
+		if (error)
+			return nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(s_CacheMutex);
+			auto cached = s_Cache.find(path);
+			if (cached != s_Cache.end() && cached->second->size == size && cached->second->writeTime == writeTime)
+			{
+				s_Stats.cacheHits++;
+				return cached->second;
+			}
+		}
+
+		// Scanned straight from the pack's mapping, or the file's
+		AssetView data = packed ? pack->Find(path) : AssetView();
+		std::unique_ptr<MappedFile> file;
+		if (!packed)
+		{
+			file = std::make_unique<MappedFile>(path);
+			if (!file->IsOpen())
+				return nullptr;
+			data = { file->GetData(), file->GetSize() };
+		}
+		else if (!data)
+		{
+			return nullptr;
+		}
+
+		auto parsed = std::make_shared<ParsedFile>(Scan(path, data.data, data.size));
+		parsed->size = data.size;
+		parsed->writeTime = writeTime;
+
+		std::lock_guard<std::mutex> lock(s_CacheMutex);
+		s_Cache[path] = parsed;
+		s_Stats.filesScanned++;
+		return parsed;
+	}
+
+	// Offset just past the #version line of text, or npos
+	size_t FindVersionEnd(const std::string& text)
+	{
+		for (size_t line = 0; line < text.size(); )
+		{
+			size_t end = text.find('\n', line);
+			end = end == std::string::npos ? text.size() : end + 1;
+			const char* p = SkipBlanks(text.data() + line, text.data() + end);
+			if (text.compare(p - text.data(), 8, "#version") == 0)
+				return end;
+			line = end;
+		}
+		return std::string::npos;
+	}
+
+	struct StageOutput
+	{
+		std::string* text;
+		std::vector<std::string> included;	// inserted once per stage
+		int file = -1;						// where the compiler's line counter is; -1 unknown
+		unsigned int line = 0;
+
+		explicit StageOutput(std::string& target)
+			: text(&target) {}
+	};
+
+	class Expansion
+	{
+	private:
+		ShaderProgramSource& m_Source;
+		bool m_Succeeded = true;
+	public:
+		explicit Expansion(ShaderProgramSource& source)
+			: m_Source(source) {}
+
+		inline bool Succeeded() const { return m_Succeeded; }
+
+		void Report(const std::string& message)
+		{
+			std::cout << message << std::endl;
+			m_Succeeded = false;
+		}
+
+		void Report(const std::vector<std::string>& messages)
+		{
+			for (const std::string& message : messages)
+				Report(message);
+		}
+
+		void Report(int file, unsigned int line, const std::string& message)
+		{
+			Report(m_Source.Files[file] + ":" + std::to_string(line) + ": error: " + message);
+		}
+
+		int GetFileIndex(const std::string& path)
+		{
+			auto it = std::find(m_Source.Files.begin(), m_Source.Files.end(), path);
+			if (it != m_Source.Files.end())
+				return static_cast<int>(it - m_Source.Files.begin());
+			m_Source.Files.push_back(path);
+			return static_cast<int>(m_Source.Files.size() - 1);
+		}
+
+		void AppendText(StageOutput& out, int file, const Chunk& chunk)
+		{
+			size_t start = 0;
+			unsigned int line = chunk.line;
+
+			// #version has to come first, so the first #line goes after it
+			if (out.text->empty())
+			{
+				const size_t version = FindVersionEnd(chunk.text);
+				if (version != std::string::npos)
+				{
+					out.text->append(chunk.text, 0, version);
+					line += static_cast<unsigned int>(std::count(chunk.text.begin(), chunk.text.begin() + version, '\n'));
+					start = version;
+					out.file = -1;
+				}
+			}
+			if (start == chunk.text.size())
+				return;
+
+			if (out.file != file || out.line != line)
+				*out.text += "#line " + std::to_string(line) + " " + std::to_string(file) + "\n";
+			out.text->append(chunk.text, start, std::string::npos);
+			out.file = file;
+			out.line = line + static_cast<unsigned int>(std::count(chunk.text.begin() + start, chunk.text.end(), '\n'));
+		}
+
+		void Include(StageOutput& out, const std::string& path, int parentFile, unsigned int parentLine)
+		{
+			if (std::find(out.included.begin(), out.included.end(), path) != out.included.end())
+				return;
+			out.included.push_back(path);
+
+			std::shared_ptr<const ParsedFile> parsed = Load(path);
+			if (!parsed)
+			{
+				Report(parentFile, parentLine, "cannot open include \"" + path + "\"");
+				return;
+			}
+
+			const int file = GetFileIndex(path);
+			Report(parsed->errors);
+			if (!parsed->keywords.empty())
+				Report(file, 1, "#keywords is only allowed in the main file");
+
+			for (const Chunk& chunk : parsed->chunks)
+			{
+				if (chunk.type == ChunkType::Text)
+					AppendText(out, file, chunk);
+				else if (chunk.type == ChunkType::Include)
+					Include(out, chunk.text, file, chunk.line);
+				else
+					Report(file, chunk.line, "#shader in an included file");
+			}
+		}
+	};
+
+}
+
+bool ShaderPreprocessor::Process(const std::string& filepath, ShaderProgramSource& source)
+{
+	source = ShaderProgramSource();
+	const std::string path = NormalizePath(filepath);
+	source.Files.push_back(path);
+
+	std::shared_ptr<const ParsedFile> parsed = Load(path);
+	if (!parsed)
+	{
+		std::cout << path << ": error: cannot open shader" << std::endl;
+		return false;
+	}
+
+	Expansion expansion(source);
+	expansion.Report(parsed->errors);
+	source.Keywords = parsed->keywords;
+
+	StageOutput stages[2] = { StageOutput(source.VertexSource), StageOutput(source.FragmentSource) };
+	StageOutput* out = nullptr;		// lines before the first #shader are ignored
+	for (const Chunk& chunk : parsed->chunks)
+	{
+		if (chunk.type == ChunkType::Stage)
+			out = &stages[chunk.stage];
+		else if (!out && chunk.type == ChunkType::Include)
+			expansion.Report(0, chunk.line, "#include before the first #shader");
+		else if (out && chunk.type == ChunkType::Text)
+			expansion.AppendText(*out, 0, chunk);
+		else if (out)
+			expansion.Include(*out, chunk.text, 0, chunk.line);
+	}
+	return expansion.Succeeded();
+}
+
+std::string ShaderPreprocessor::MapLog(const std::string& log, const std::vector<std::string>& files)
+{
+	std::string result;
+	result.reserve(log.size());
+	for (size_t start = 0; start < log.size(); )
+	{
+		size_t end = log.find('\n', start);
+		end = end == std::string::npos ? log.size() : end + 1;
+		std::string line = log.substr(start, end - start);
+		start = end;
+
+		// Some drivers put the severity first
+		size_t number = 0;
+		for (const char* prefix : { "ERROR: ", "WARNING: " })
+		{
+			if (line.compare(0, std::strlen(prefix), prefix) == 0)
+				number = std::strlen(prefix);
+		}
+
+		size_t digits = number;
+		while (digits < line.size() && std::isdigit(static_cast<unsigned char>(line[digits])))
+			digits++;
+		if (digits > number && digits + 1 < line.size() && (line[digits] == ':' || line[digits] == '(') &&
+			std::isdigit(static_cast<unsigned char>(line[digits + 1])))
+		{
+			const unsigned long file = std::stoul(line.substr(number, digits - number));
+			if (file < files.size())
+				line.replace(number, digits - number, files[file]);
+		}
+		result += line;
+	}
+	return result;
+}
+
+void ShaderPreprocessor::ClearCache()
+{
+	std::lock_guard<std::mutex> lock(s_CacheMutex);
+	s_Cache.clear();
+}
+
+ShaderPreprocessorStats ShaderPreprocessor::GetStats()
+{
+	std::lock_guard<std::mutex> lock(s_CacheMutex);
+	return s_Stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+struct ShaderPreprocessorStats
+{
+	unsigned int filesScanned = 0;		// files mapped and scanned
+	unsigned int cacheHits = 0;			// files served from the parsed-file cache
+};
+
+// Turns a .shader file into per-stage GLSL sources.
+//
+// Files are memory-mapped (or read from the mounted AssetPack, which
+// takes precedence) and scanned once, line by line, for the directives
+// below; everything else is copied through untouched.
+//
+//	#keywords A B ...	(before the first stage) variant keywords, see Shader
+//	#shader vertex		starts a stage (vertex or fragment); main file only
+//	#include "file"		inserts file, relative to the including file
+//	#pragma once		accepted and dropped
+//
+// An included file is inserted at most once per stage, so shared headers
+// need no guards and include cycles end by themselves.
+//
+// Scanned files stay in a process-wide cache, keyed by path and checked
+// against the file's size and write time on every use, so N shaders
+// sharing one library read and scan it once. Each stage carries
+// "#line <line> <file>" directives, where <file> indexes
+// ShaderProgramSource::Files; MapLog turns the numbers in a compiler log
+// back into paths, so errors point at the original file and line.
+class ShaderPreprocessor
+{
+public:
+	// Fills source; on errors (missing files, bad directives) prints them as
+	// "file:line: error: ..." and returns false, with source as far as it got
+	static bool Process(const std::string& filepath, ShaderProgramSource& source);
+
+	// Replaces the source string numbers that compilers put at the start of
+	// log lines ("0:12(3): ...", "0(12) : ...", "ERROR: 0:12: ...") by the
+	// file names
+	static std::string MapLog(const std::string& log, const std::vector<std::string>& files);
+
+	static void ClearCache();
+	static ShaderPreprocessorStats GetStats();
+};
@@ -0,0 +1,65 @@
+#include "ShaderReloader.h"
+
+#include "Shader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+void ShaderReloader::Add(Shader& shader)
+{
+	if (std::find(m_Shaders.begin(), m_Shaders.end(), &shader) != m_Shaders.end())
+		return;
+
+	WatchSourceFiles(shader);
+	m_Shaders.push_back(&shader);
+}
+
+void ShaderReloader::WatchSourceFiles(const Shader& shader)
+{
+	for (const std::string& file : shader.GetSourceFiles())
+		m_Watcher.Watch(std::filesystem::path(file).parent_path().generic_string());
+}
+
+void ShaderReloader::Remove(const Shader& shader)
+{
+	m_Shaders.erase(std::remove(m_Shaders.begin(), m_Shaders.end(), &shader), m_Shaders.end());
+}
+
+void ShaderReloader::Update()
+{
+	m_Changed.clear();
+	m_Watcher.Poll(m_Changed);
+	for (const std::string& path : m_Changed)
+	{
+		for (Shader* shader : m_Shaders)
+		{
+			// Source files are already normalized by the preprocessor
+			const std::vector<std::string>& files = shader->GetSourceFiles();
+			if (std::find(files.begin(), files.end(), path) == files.end())
+				continue;
+
+			std::cout << "Reloading " << shader->GetFilePath() << " (" << path << " changed)" << std::endl;
+			shader->Reload();
+			// The edit may have added includes from other directories
+			WatchSourceFiles(*shader);
+		}
+	}
+
+	for (Shader* shader : m_Shaders)
+	{
+		switch (shader->PollReload())
+		{
+		case ShaderReloadStatus::Swapped:
+			m_Status = "Reloaded " + shader->GetFilePath();
+			std::cout << m_Status << std::endl;
+			break;
+		case ShaderReloadStatus::Failed:
+			m_Status = shader->GetFilePath() + " failed, keeping the previous program";
+			std::cout << m_Status << std::endl;
+			break;
+		default:
+			break;
+		}
+	}
+}
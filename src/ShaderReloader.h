@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "FileWatcher.h"
+
+class Shader;
+
+// Hot reload for shaders: watches the directories of the registered
+// shaders and of everything they #include and, when one of those files is
+// written, recompiles the shaders using it in the background (see
+// Shader::Reload). Programs are swapped in only once they
+// have linked, so a broken edit keeps the previous program on screen.
+//
+// Call Update once per frame, before anything is drawn.
+class ShaderReloader
+{
+private:
+	FileWatcher m_Watcher;
+	std::vector<Shader*> m_Shaders;
+	std::vector<std::string> m_Changed;		// reused between frames
+	std::string m_Status;					// last reload result, for the UI
+
+	void WatchSourceFiles(const Shader& shader);
+public:
+	ShaderReloader() = default;
+
+	// The shader must outlive the reloader or be removed first
+	void Add(Shader& shader);
+	void Remove(const Shader& shader);
+
+	void Update();
+
+	inline const std::string& GetStatus() const { return m_Status; }
+	inline bool IsNative() const { return m_Watcher.IsNative(); }
+};
@@ -0,0 +1,163 @@
+#include "SpriteBatch.h"
+
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "Texture.h"
+
+#include <cmath>
+
+static uint32_t PackColor(const glm::vec4& color)
+{
+	glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+	return static_cast<uint32_t>(c.r) |
+		(static_cast<uint32_t>(c.g) << 8) |
+		(static_cast<uint32_t>(c.b) << 16) |
+		(static_cast<uint32_t>(c.a) << 24);
+}
+
+SpriteBatch::SpriteBatch(StreamBuffer& stream, unsigned int maxQuads)
+	: m_Stream(stream), m_MaxQuads(maxQuads), m_Write(nullptr), m_QuadCount(0),
+	m_Shader(nullptr), m_UniformShader(nullptr), m_Texture(nullptr), m_InBatch(false)
+{
+	// Every quad uses the same index pattern, so the index buffer is static
+	std::vector<unsigned int> indices(maxQuads * 6);
+	for (unsigned int quad = 0; quad < maxQuads; quad++)
+	{
+		const unsigned int base = quad * 4;
+		unsigned int* index = &indices[quad * 6];
+		index[0] = base + 0; index[1] = base + 1; index[2] = base + 2;
+		index[3] = base + 2; index[4] = base + 3; index[5] = base + 0;
+	}
+
+	// Attributes point at the start of the stream buffer; each batch's range
+	// is selected with the base vertex of the draw
+	m_VertexArray = std::make_unique<VertexArray>();
+
+	VertexBufferLayout layout;
+	layout.Push<float>(2);			// position
+	layout.Push<float>(2);			// tex coords
+	layout.Push<unsigned char>(4);	// color
+	m_VertexArray->AddBuffer(m_Stream.GetRendererID(), layout);
+
+	m_IndexBuffer = std::make_unique<IndexBuffer>(indices.data(), maxQuads * 6);
+}
+
+SpriteBatch::~SpriteBatch() = default;
+
+void SpriteBatch::Begin(const Shader& shader)
+{
+	m_Shader = &shader;
+	m_Texture = nullptr;
+	m_Write = nullptr;
+	m_QuadCount = 0;
+	m_Stats = SpriteBatchStats();
+	m_InBatch = true;
+
+	shader.Bind();
+	if (&shader != m_UniformShader)
+	{
+		m_TextureUniform = shader.GetUniform("u_Texture");
+		m_UniformShader = &shader;
+	}
+	shader.SetUniform1i(m_TextureUniform, 0);
+}
+
+SpriteVertex* SpriteBatch::PrepareQuad(const Texture* texture)
+{
+	if (texture != m_Texture || m_QuadCount == m_MaxQuads)
+	{
+		Flush();
+		m_Texture = texture;
+	}
+
+	if (!m_Write)
+	{
+		// Reserve room for a full batch; Flush hands the unused tail back
+		m_Allocation = m_Stream.Allocate(m_MaxQuads * 4 * static_cast<unsigned int>(sizeof(SpriteVertex)), sizeof(SpriteVertex));
+		m_Write = static_cast<SpriteVertex*>(m_Allocation.data);
+		if (!m_Write)
+			return nullptr;
+	}
+
+	SpriteVertex* quad = m_Write + m_QuadCount * 4;
+	m_QuadCount++;
+	m_Stats.quads++;
+	return quad;
+}
+
+void SpriteBatch::Submit(const glm::vec4& rect, const Texture* texture, const glm::vec4& color,
+	const glm::mat4& transform, const glm::vec4& uvRect)
+{
+	ASSERT(m_InBatch);
+	SpriteVertex* v = PrepareQuad(texture);
+	if (!v)
+		return;
+
+	// Only x/y of the result are used, so the affine 2D part of the matrix suffices
+	const glm::vec2 axisX(transform[0]);
+	const glm::vec2 axisY(transform[1]);
+	const glm::vec2 origin(transform[3]);
+	const uint32_t packed = PackColor(color);
+
+	const float x0 = rect.x, y0 = rect.y;
+	const float x1 = rect.x + rect.z, y1 = rect.y + rect.w;
+
+	v[0] = { origin + axisX * x0 + axisY * y0, { uvRect.x, uvRect.y }, packed };
+	v[1] = { origin + axisX * x1 + axisY * y0, { uvRect.z, uvRect.y }, packed };
+	v[2] = { origin + axisX * x1 + axisY * y1, { uvRect.z, uvRect.w }, packed };
+	v[3] = { origin + axisX * x0 + axisY * y1, { uvRect.x, uvRect.w }, packed };
+}
+
+void SpriteBatch::Submit(const glm::vec2& position, const glm::vec2& size, float rotation,
+	const Texture* texture, const glm::vec4& color, const glm::vec4& uvRect)
+{
+	ASSERT(m_InBatch);
+	SpriteVertex* v = PrepareQuad(texture);
+	if (!v)
+		return;
+
+	const float c = std::cos(rotation);
+	const float s = std::sin(rotation);
+	const glm::vec2 axisX = glm::vec2(c, s) * (size.x * 0.5f);
+	const glm::vec2 axisY = glm::vec2(-s, c) * (size.y * 0.5f);
+	const uint32_t packed = PackColor(color);
+
+	v[0] = { position - axisX - axisY, { uvRect.x, uvRect.y }, packed };
+	v[1] = { position + axisX - axisY, { uvRect.z, uvRect.y }, packed };
+	v[2] = { position + axisX + axisY, { uvRect.z, uvRect.w }, packed };
+	v[3] = { position - axisX + axisY, { uvRect.x, uvRect.w }, packed };
+}
+
+void SpriteBatch::End()
+{
+	ASSERT(m_InBatch);
+	Flush();
+	m_InBatch = false;
+}
+
+void SpriteBatch::Flush()
+{
+	if (!m_Write)
+		return;
+
+	const unsigned int quadCount = m_QuadCount;
+	m_Stream.Commit(m_Allocation, quadCount * 4 * static_cast<unsigned int>(sizeof(SpriteVertex)));
+	m_Write = nullptr;
+	m_QuadCount = 0;
+	if (quadCount == 0)
+		return;
+
+	m_Shader->Bind();
+	m_VertexArray->Bind();
+	m_IndexBuffer->Bind();
+	if (m_Texture)
+		m_Texture->Bind(0);
+
+	// 2D content is drawn in submission order on top of the scene
+	const GLint baseVertex = static_cast<GLint>(m_Allocation.offset / sizeof(SpriteVertex));
+	GLCall(glDisable(GL_DEPTH_TEST));
+	GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, quadCount * 6, GL_UNSIGNED_INT, nullptr, baseVertex));
+	GLCall(glEnable(GL_DEPTH_TEST));
+
+	m_Stats.drawCalls++;
+}
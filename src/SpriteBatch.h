@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.h"
+#include "Shader.h"
+
+class Texture;
+class VertexArray;
+class IndexBuffer;
+
+struct SpriteVertex
+{
+	glm::vec2 position;
+	glm::vec2 texCoord;
+	uint32_t color;		// RGBA8, normalized in the shader
+};
+
+struct SpriteBatchStats
+{
+	unsigned int quads = 0;
+	unsigned int drawCalls = 0;
+};
+
+// Batches textured quads into the renderer's stream buffer. Vertices are
+// transformed on the CPU and written straight into mapped memory, so every
+// quad sharing a texture goes out in a single draw; a batch is flushed when
+// the texture changes or it reaches maxQuads.
+//
+//	batch.Begin(shader);
+//	batch.Submit(rect, texture, color, transform);
+//	batch.End();
+//
+// The shader is expected to take position (location 0), texCoord (1) and
+// color (2), with u_Texture on slot 0. The view-projection comes from the
+// ViewData uniform block, which the caller binds before Begin.
+class SpriteBatch
+{
+private:
+	StreamBuffer& m_Stream;
+	std::unique_ptr<VertexArray> m_VertexArray;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	unsigned int m_MaxQuads;
+
+	StreamAllocation m_Allocation;	// vertex range the current batch writes to
+	SpriteVertex* m_Write;
+	unsigned int m_QuadCount;
+
+	const Shader* m_Shader;
+	const Shader* m_UniformShader;	// shader m_TextureUniform was resolved for
+	UniformHandle m_TextureUniform;
+	const Texture* m_Texture;
+	bool m_InBatch;
+	SpriteBatchStats m_Stats;
+public:
+	SpriteBatch(StreamBuffer& stream, unsigned int maxQuads = 16384);
+	~SpriteBatch();
+
+	void Begin(const Shader& shader);
+
+	// rect is the local quad (x, y, width, height) placed by transform;
+	// uvRect is (u0, v0, u1, v1)
+	void Submit(const glm::vec4& rect, const Texture* texture, const glm::vec4& color,
+		const glm::mat4& transform, const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+	// 2D fast path: quad of the given size centered on position, rotated in radians
+	void Submit(const glm::vec2& position, const glm::vec2& size, float rotation, const Texture* texture,
+		const glm::vec4& color, const glm::vec4& uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+
+	void End();
+
+	// Stats of the last Begin/End pair
+	inline const SpriteBatchStats& GetStats() const { return m_Stats; }
+
+private:
+	// Returns where the next quad's four vertices go, or null if the stream buffer is full
+	SpriteVertex* PrepareQuad(const Texture* texture);
+	void Flush();
+};
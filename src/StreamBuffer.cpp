@@ -0,0 +1,191 @@
+#include "StreamBuffer.h"
+
+#include "Renderer.h"
+#include "GLState.h"
+
+#include <cstring>
+#include <iostream>
+
+static unsigned int AlignUp(unsigned int value, unsigned int alignment)
+{
+	if (alignment <= 1)
+		return value;
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+StreamBuffer::StreamBuffer(unsigned int sizePerFrame)
+	: m_RendererID(0), m_FrameSize(sizePerFrame), m_Size(sizePerFrame * FrameCount),
+	m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_Frame(0), m_Head(0), m_Limit(0),
+	m_RangeMapped(false), m_WarnedFull(false)
+{
+	// Mapping goes through GL_COPY_WRITE_BUFFER so vertex/element bindings stay untouched
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+
+	m_Persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	if (m_Persistent)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, m_Size, nullptr, flags));
+		GLCall(m_Mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_Size, flags)));
+		if (!m_Mapped)
+		{
+			// Storage is immutable now, so recreate the buffer for the fallback path
+			std::cout << "Warning: persistent mapping failed, falling back to orphaning" << std::endl;
+			GLCall(glDeleteBuffers(1, &m_RendererID));
+			GLState::OnBufferDeleted(m_RendererID);
+			GLCall(glGenBuffers(1, &m_RendererID));
+			GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+			m_Persistent = false;
+		}
+	}
+	if (!m_Persistent)
+	{
+		GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+	}
+
+	m_Limit = m_FrameSize;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (unsigned int i = 0; i < FrameCount; i++)
+	{
+		if (m_Fences[i])
+		{
+			GLCall(glDeleteSync(static_cast<GLsync>(m_Fences[i])));
+		}
+	}
+	if (m_Mapped || m_RangeMapped)
+	{
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+		GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+	}
+	GLCall(glDeleteBuffers(1, &m_RendererID));
+	GLState::OnBufferDeleted(m_RendererID);
+}
+
+void StreamBuffer::BeginFrame()
+{
+	if (!m_Persistent)
+	{
+		// Orphan between frames rather than mid-frame, so ranges handed out
+		// earlier in the frame keep pointing at the storage they were written to
+		if (m_Head + m_FrameSize > m_Size)
+		{
+			GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+			GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+			m_Head = 0;
+		}
+		m_Limit = m_Head + m_FrameSize;
+		return;
+	}
+
+	m_Frame = (m_Frame + 1) % FrameCount;
+	m_Head = m_Frame * m_FrameSize;
+	m_Limit = m_Head + m_FrameSize;
+
+	// Wait until the GPU has finished the frame that last used this segment
+	GLsync fence = static_cast<GLsync>(m_Fences[m_Frame]);
+	if (fence)
+	{
+		GLbitfield waitFlags = 0;
+		for (;;)
+		{
+			GLenum result = glClientWaitSync(fence, waitFlags, 1000000); // 1 ms
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+				break;
+			waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		}
+		GLCall(glDeleteSync(fence));
+		m_Fences[m_Frame] = nullptr;
+	}
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (!m_Persistent)
+		return;
+
+	if (m_Fences[m_Frame])
+	{
+		GLCall(glDeleteSync(static_cast<GLsync>(m_Fences[m_Frame])));
+	}
+	GLCall(m_Fences[m_Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+StreamAllocation StreamBuffer::Allocate(unsigned int size, unsigned int alignment)
+{
+	StreamAllocation allocation;
+	ASSERT(!m_RangeMapped);
+
+	const unsigned int offset = AlignUp(m_Head, alignment);
+	if (offset + size > m_Limit)
+	{
+		if (!m_WarnedFull)
+		{
+			std::cout << "Warning: stream buffer full (" << m_FrameSize << " bytes per frame)" << std::endl;
+			m_WarnedFull = true;
+		}
+		return allocation;
+	}
+
+	allocation.offset = offset;
+	allocation.size = size;
+	if (m_Persistent)
+	{
+		allocation.data = m_Mapped + offset;
+	}
+	else
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+			GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+		GLCall(allocation.data = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, flags));
+		if (!allocation.data)
+			return StreamAllocation();
+		m_RangeMapped = true;
+	}
+	m_Head = offset + size;
+	return allocation;
+}
+
+void StreamBuffer::Commit(StreamAllocation& allocation, unsigned int usedSize)
+{
+	if (!allocation.data)
+		return;
+	if (usedSize > allocation.size)
+		usedSize = allocation.size;
+
+	if (m_RangeMapped)
+	{
+		GLState::BindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID);
+		if (usedSize > 0)
+		{
+			GLCall(glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, usedSize));
+		}
+		GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+		m_RangeMapped = false;
+	}
+
+	// Give back the unused tail if nothing was allocated after this range
+	if (allocation.offset + allocation.size == m_Head)
+		m_Head = allocation.offset + usedSize;
+	allocation.size = usedSize;
+}
+
+StreamAllocation StreamBuffer::Upload(const void* data, unsigned int size, unsigned int alignment)
+{
+	StreamAllocation allocation = Allocate(size, alignment);
+	if (!allocation.data)
+		return allocation;
+
+	std::memcpy(allocation.data, data, size);
+	Commit(allocation);
+	return allocation;
+}
+
+void StreamBuffer::Bind(unsigned int target) const
+{
+	GLState::BindBuffer(target, m_RendererID);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+
+struct StreamAllocation
+{
+	void* data = nullptr;		// CPU-writable memory, null if the allocation failed
+	unsigned int offset = 0;	// byte offset into the buffer, for attribute pointers / bind ranges
+	unsigned int size = 0;
+};
+
+// Ring buffer for data rewritten every frame (dynamic vertices, instance
+// data, uniform blocks). Users sub-allocate ranges, write them from the CPU
+// and point the GPU at GetRendererID() + offset.
+//
+// With ARB_buffer_storage the buffer is mapped once, persistently and
+// coherently, and split into FrameCount segments; a fence per segment keeps
+// the CPU from overwriting data the GPU has not consumed yet. Without it,
+// ranges are mapped with glMapBufferRange(UNSYNCHRONIZED) and the storage
+// is orphaned at the start of a frame that would not fit before the end.
+// Either way the driver never has to stall on an implicit sync, and every
+// range stays valid until the end of the frame it was allocated in (uniform
+// block ranges are bound once and read by many draws).
+//
+// Call BeginFrame before the first allocation of a frame and EndFrame after
+// the last draw that reads from the buffer.
+class StreamBuffer
+{
+public:
+	static constexpr unsigned int FrameCount = 3;
+
+private:
+	unsigned int m_RendererID;
+	unsigned int m_FrameSize;
+	unsigned int m_Size;
+	bool m_Persistent;
+	unsigned char* m_Mapped;				// persistent mapping of the whole buffer
+	void* m_Fences[FrameCount];				// GLsync per segment
+	unsigned int m_Frame;					// current segment
+	unsigned int m_Head;					// next free byte (absolute offset)
+	unsigned int m_Limit;					// end of the current segment / buffer
+	bool m_RangeMapped;						// fallback path: a range is currently mapped
+	bool m_WarnedFull;
+public:
+	StreamBuffer(unsigned int sizePerFrame);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Reserves size bytes at an offset that is a multiple of alignment (any
+	// value, e.g. a vertex stride). The memory must be written before the
+	// next Allocate and handed back with Commit before the GPU reads it.
+	StreamAllocation Allocate(unsigned int size, unsigned int alignment = 16);
+	// Finishes writing an allocation, shrinking it to usedSize bytes if the
+	// caller wrote less than it reserved. data must not be written afterwards.
+	void Commit(StreamAllocation& allocation, unsigned int usedSize);
+	void Commit(StreamAllocation& allocation) { Commit(allocation, allocation.size); }
+
+	// Allocate + copy + Commit
+	StreamAllocation Upload(const void* data, unsigned int size, unsigned int alignment = 16);
+
+	void Bind(unsigned int target) const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetFrameSize() const { return m_FrameSize; }
+	inline bool IsPersistent() const { return m_Persistent; }
+};
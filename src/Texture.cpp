@@ -0,0 +1,331 @@
+#include "Texture.h"
+
+#include "AssetPack.h"
+#include "GLState.h"
+#include "MipGenerator.h"
+#include "TextureCompressor.h"
+#include "TextureLoader.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <cstdint>
+
+float Texture::s_DefaultAnisotropy = 1.0f;
+
+Texture::Texture(const std::string& path, TextureMipmaps mipmaps /*= TextureMipmaps::Precomputed*/)
+	: m_RendererID(0), m_Target(GL_TEXTURE_2D), m_FilePath(path), m_LocalBuffer(nullptr),
+	m_Width(0), m_Height(0), m_BPP(0), m_Layers(1), m_Format(GL_RGBA8), m_Mipmaps(mipmaps), m_LevelCount(1),
+	m_BaseLevel(0), m_MinLod(0.0f), m_DroppedLevels(0), m_Compressed(false), m_Anisotropy(1.0f), m_BindCount(0), m_Loader(nullptr), m_LoadTicket(0), m_Streamer(nullptr)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	SetAnisotropy(s_DefaultAnisotropy);
+
+	MipChain chain;
+	if (mipmaps == TextureMipmaps::Precomputed && MipGenerator::LoadCached(path, chain))
+	{
+		SetMipChain(chain, chain.pixels.data());
+		return;
+	}
+
+	stbi_set_flip_vertically_on_load(1);
+	const AssetView asset = AssetPack::FindMounted(path);
+	m_LocalBuffer = asset
+		? stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(asset.data), static_cast<int>(asset.size), &m_Width, &m_Height, &m_BPP, 4)
+		: stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	if (m_LocalBuffer && mipmaps == TextureMipmaps::Precomputed)
+	{
+		MipGenerator::Build(m_LocalBuffer, m_Width, m_Height, chain);
+		MipGenerator::StoreCached(path, chain);
+		SetMipChain(chain, chain.pixels.data());
+	}
+	else
+	{
+		SetImage(m_Width, m_Height, m_LocalBuffer);
+	}
+
+	if (m_LocalBuffer) {
+		stbi_image_free(m_LocalBuffer);
+		m_LocalBuffer = nullptr;
+	}
+}
+
+Texture::Texture(TextureMipmaps mipmaps /*= TextureMipmaps::None*/)
+	: m_RendererID(0), m_Target(GL_TEXTURE_2D), m_LocalBuffer(nullptr),
+	m_Width(0), m_Height(0), m_BPP(4), m_Layers(1), m_Format(GL_RGBA8), m_Mipmaps(mipmaps), m_LevelCount(1),
+	m_BaseLevel(0), m_MinLod(0.0f), m_DroppedLevels(0), m_Compressed(false), m_Anisotropy(1.0f), m_BindCount(0), m_Loader(nullptr), m_LoadTicket(0), m_Streamer(nullptr)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	SetAnisotropy(s_DefaultAnisotropy);
+	SetPlaceholder();
+}
+
+Texture::Texture(int width, int height, int layers)
+	: m_RendererID(0), m_Target(GL_TEXTURE_2D_ARRAY), m_LocalBuffer(nullptr),
+	m_Width(width), m_Height(height), m_BPP(4), m_Layers(layers), m_Format(GL_RGBA8),
+	m_Mipmaps(TextureMipmaps::Precomputed), m_LevelCount(1), m_BaseLevel(0), m_MinLod(0.0f), m_DroppedLevels(0), m_Compressed(false), m_Anisotropy(1.0f),
+	m_BindCount(0), m_Loader(nullptr), m_LoadTicket(0), m_Streamer(nullptr)
+{
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+	GLCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+	// Storage for every level up front; layers are filled in later
+	const int levelCount = GetFullLevelCount(width, height);
+	for (int level = 0; level < levelCount; level++)
+	{
+		GLCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(width >> level, 1), std::max(height >> level, 1),
+			layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	SetLevelCount(levelCount);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	SetAnisotropy(s_DefaultAnisotropy);
+}
+
+Texture::~Texture()
+{
+	if (m_Loader)
+		m_Loader->Cancel(*this);
+	if (m_Streamer)
+		m_Streamer->Cancel(*this);
+	GLCall(glDeleteTextures(1, &m_RendererID));
+	GLState::OnTextureDeleted(m_RendererID);
+}
+
+void Texture::SetImage(int width, int height, const void* pixels)
+{
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+	if (m_Mipmaps == TextureMipmaps::Driver && width > 0 && height > 0)
+	{
+		// Filtered by the driver, usually a plain box on the encoded values
+		GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+		SetLevelCount(GetFullLevelCount(width, height));
+	}
+	else
+	{
+		SetLevelCount(1);
+	}
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	m_Width = width;
+	m_Height = height;
+	m_Format = GL_RGBA8;
+	m_DroppedLevels = 0;
+	m_Compressed = false;
+}
+
+void Texture::SetMipChain(const MipChain& chain, const void* pixels, int baseLevel /*= 0*/)
+{
+	const int levelCount = static_cast<int>(chain.levels.size());
+	baseLevel = std::min(std::max(baseLevel, 0), levelCount - 1);
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	// Empty, freeing whatever an earlier image left there
+	for (int i = 0; i < baseLevel; i++)
+	{
+		GLCall(glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	UploadLevels(chain, pixels, baseLevel, levelCount);
+	SetLevelCount(levelCount, baseLevel);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	m_Width = chain.levels[0].width;
+	m_Height = chain.levels[0].height;
+	m_Format = GL_RGBA8;
+	m_DroppedLevels = 0;
+	m_Compressed = false;
+}
+
+void Texture::SetCompressedImage(const CompressedImage& image, int baseLevel /*= 0*/)
+{
+	const int levelCount = static_cast<int>(image.levels.size());
+	baseLevel = std::min(std::max(baseLevel, 0), levelCount - 1);
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	for (int i = 0; i < baseLevel; i++)
+	{
+		GLCall(glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	}
+	UploadLevels(image, baseLevel, levelCount);
+	SetLevelCount(levelCount, baseLevel);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	m_Width = image.levels[0].width;
+	m_Height = image.levels[0].height;
+	m_Format = image.format;
+	m_DroppedLevels = 0;
+	m_Compressed = true;
+}
+
+void Texture::AddLevels(const MipChain& chain, const void* pixels, int baseLevel)
+{
+	baseLevel = std::max(baseLevel, 0);
+	if (baseLevel >= m_BaseLevel)
+		return;
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	UploadLevels(chain, pixels, baseLevel, m_LevelCount);
+	SetLevelCount(m_LevelCount, baseLevel);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::AddLevels(const CompressedImage& image, int baseLevel)
+{
+	baseLevel = std::max(baseLevel, 0);
+	if (baseLevel >= m_BaseLevel)
+		return;
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	UploadLevels(image, baseLevel, m_LevelCount);
+	SetLevelCount(m_LevelCount, baseLevel);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::UploadLevels(const MipChain& chain, const void* pixels, int first, int last)
+{
+	// pixels may be a buffer offset, so this is integer arithmetic rather than pointer arithmetic
+	const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(pixels);
+	for (int i = first; i < last; i++)
+	{
+		const MipLevel& level = chain.levels[i];
+		GLCall(glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA8, level.width, level.height, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(base + level.offset)));
+	}
+}
+
+void Texture::UploadLevels(const CompressedImage& image, int first, int last)
+{
+	for (int i = first; i < last; i++)
+	{
+		const CompressedLevel& level = image.levels[i];
+		GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, i, image.format, level.width, level.height, 0,
+			static_cast<int>(level.size), image.data + level.offset));
+	}
+}
+
+void Texture::SetMinLod(float lod)
+{
+	GLState::BindTexture(m_Target, m_RendererID);
+	GLCall(glTexParameterf(m_Target, GL_TEXTURE_MIN_LOD, lod));
+	GLState::BindTexture(m_Target, 0);
+	m_MinLod = lod;
+}
+
+void Texture::SetPlaceholder()
+{
+	// Neutral grey, so unloaded textures read as "not there yet" rather than as content
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	SetImage(1, 1, placeholder);
+}
+
+void Texture::SetLayer(int layer, const MipChain& chain, const void* pixels)
+{
+	const unsigned char* base = static_cast<const unsigned char*>(pixels);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID);
+	const size_t levelCount = std::min(chain.levels.size(), static_cast<size_t>(m_LevelCount));
+	for (size_t i = 0; i < levelCount; i++)
+	{
+		const MipLevel& level = chain.levels[i];
+		GLCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<int>(i), 0, 0, layer, level.width, level.height, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, base + level.offset));
+	}
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+size_t Texture::GetImageSize(unsigned int format, int width, int height)
+{
+	if (format == GL_RGBA8)
+		return size_t(width) * height * 4;
+	// S3TC: 4x4 blocks of 8 (DXT1) or 16 bytes
+	const size_t blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+	return blocks * (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16);
+}
+
+size_t Texture::GetMemorySize() const
+{
+	size_t size = 0;
+	for (int level = m_BaseLevel; level < m_LevelCount; level++)
+		size += GetImageSize(m_Format, std::max(m_Width >> level, 1), std::max(m_Height >> level, 1));
+	return size * m_Layers;
+}
+
+int Texture::GetFullLevelCount(int width, int height)
+{
+	int levels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+		levels++;
+	return levels;
+}
+
+void Texture::SetLevelCount(int levelCount, int baseLevel /*= 0*/)
+{
+	// A max level past the uploaded ones would leave the texture incomplete;
+	// so would a base level before them
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+	GLCall(glTexParameteri(m_Target, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+	if (baseLevel != m_BaseLevel)
+	{
+		GLCall(glTexParameteri(m_Target, GL_TEXTURE_BASE_LEVEL, baseLevel));
+	}
+	if (m_MinLod != 0.0f)
+	{
+		GLCall(glTexParameterf(m_Target, GL_TEXTURE_MIN_LOD, 0.0f));
+	}
+	m_LevelCount = levelCount;
+	m_BaseLevel = baseLevel;
+	m_MinLod = 0.0f;
+}
+
+void Texture::SetAnisotropy(float anisotropy)
+{
+	const float maxAnisotropy = GetMaxAnisotropy();
+	anisotropy = std::min(std::max(anisotropy, 1.0f), maxAnisotropy);
+	if (maxAnisotropy > 1.0f)
+	{
+		GLState::BindTexture(m_Target, m_RendererID);
+		GLCall(glTexParameterf(m_Target, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy));
+		GLState::BindTexture(m_Target, 0);
+	}
+	m_Anisotropy = anisotropy;
+}
+
+float Texture::GetMaxAnisotropy()
+{
+	// Queried once; the limit is per context and the app has one
+	static float maxAnisotropy = 0.0f;
+	if (maxAnisotropy == 0.0f)
+	{
+		maxAnisotropy = 1.0f;
+		if (GLEW_EXT_texture_filter_anisotropic || GLEW_ARB_texture_filter_anisotropic)
+		{
+			GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy));
+		}
+	}
+	return maxAnisotropy;
+}
+
+void Texture::SetDefaultAnisotropy(float anisotropy)
+{
+	s_DefaultAnisotropy = std::max(anisotropy, 1.0f);
+}
+
+void Texture::Bind(unsigned int slot /*= 0*/) const
+{
+	m_BindCount++;
+	GLState::BindTexture(slot, m_Target, m_RendererID);
+}
+
+void Texture::Unbind() const
+{
+	GLState::BindTexture(m_Target, 0);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Renderer.h"
+
+class TextureLoader;
+struct MipChain;
+struct CompressedImage;
+
+enum class TextureMipmaps
+{
+	None,			// one level, linear filtering
+	Driver,			// glGenerateMipmap after each upload
+	Precomputed		// gamma-correct chain from MipGenerator, cached next to the image
+};
+
+class Texture {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Target;		// GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY
+	std::string m_FilePath;
+	unsigned char* m_LocalBuffer;
+	int m_Width, m_Height, m_BPP;
+	int m_Layers;
+	unsigned int m_Format;		// GL internal format of the levels
+	TextureMipmaps m_Mipmaps;
+	int m_LevelCount;
+	int m_BaseLevel;			// finest level uploaded; finer ones are still streaming
+	float m_MinLod;
+	int m_DroppedLevels;		// largest levels of the source left out (see TextureLoader::Reload)
+	bool m_Compressed;
+	float m_Anisotropy;
+	mutable unsigned int m_BindCount;
+
+	static float s_DefaultAnisotropy;
+
+	// Filtering, GL_TEXTURE_MAX_LEVEL for levelCount levels and
+	// GL_TEXTURE_BASE_LEVEL, on the bound texture
+	void SetLevelCount(int levelCount, int baseLevel = 0);
+	// Levels [first, last) at their own level numbers, on the bound texture
+	void UploadLevels(const MipChain& chain, const void* pixels, int first, int last);
+	void UploadLevels(const CompressedImage& image, int first, int last);
+	// Levels down to 1x1
+	static int GetFullLevelCount(int width, int height);
+
+	// Set while a TextureLoader is filling this texture
+	TextureLoader* m_Loader;
+	unsigned int m_LoadTicket;
+	// Set while a TextureLoader has finer levels for it (see LoadStreamed)
+	TextureLoader* m_Streamer;
+
+	friend class TextureLoader;
+public:
+	Texture(const std::string& path, TextureMipmaps mipmaps = TextureMipmaps::Precomputed);
+	// A 1x1 placeholder, for images that arrive later (see TextureLoader)
+	Texture(TextureMipmaps mipmaps = TextureMipmaps::None);
+	// An empty GL_TEXTURE_2D_ARRAY of layers width x height RGBA8 images,
+	// repeating, with a full mip chain (see TextureArrayManager)
+	Texture(int width, int height, int layers);
+	~Texture();
+
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
+	void Bind(unsigned int slot = 0)const;
+	void Unbind()const;
+
+	// Replaces the image with width x height RGBA8 pixels. With a buffer
+	// bound to GL_PIXEL_UNPACK_BUFFER, pixels is an offset into it.
+	// With TextureMipmaps::Driver the other levels are generated from it.
+	void SetImage(int width, int height, const void* pixels);
+	// Replaces the image with every level of chain. pixels is chain.pixels,
+	// or its offset in a bound GL_PIXEL_UNPACK_BUFFER. With a baseLevel,
+	// the finer levels are left empty and sampling starts at baseLevel
+	// until AddLevels brings them.
+	void SetMipChain(const MipChain& chain, const void* pixels, int baseLevel = 0);
+	// Replaces the image with the block-compressed levels of image
+	void SetCompressedImage(const CompressedImage& image, int baseLevel = 0);
+	// Uploads the levels from baseLevel on, of the chain or image the texture
+	// was set from, and moves the base there. The coarser levels go up
+	// again with them: drivers reallocate the mip tree for a larger level
+	// and don't all carry the others over (Mesa drops them for non-power-
+	// of-two chains). That adds a third at most.
+	void AddLevels(const MipChain& chain, const void* pixels, int baseLevel);
+	void AddLevels(const CompressedImage& image, int baseLevel);
+	// Back to the 1x1 placeholder, freeing the image's storage
+	void SetPlaceholder();
+	// The Set* calls above are for GL_TEXTURE_2D; arrays are filled a layer
+	// at a time from a chain of the array's size, as for SetMipChain
+	void SetLayer(int layer, const MipChain& chain, const void* pixels);
+
+	// GL_TEXTURE_MIN_LOD, relative to the base level: above 0 the finest
+	// levels are blended in (or kept out) gradually. Set* reset it to 0.
+	void SetMinLod(float lod);
+
+	// Clamped to [1, GetMaxAnisotropy()]; 1 is plain trilinear filtering
+	void SetAnisotropy(float anisotropy);
+	// 1 when GL_EXT_texture_filter_anisotropic is missing
+	static float GetMaxAnisotropy();
+	// For textures created afterwards
+	static void SetDefaultAnisotropy(float anisotropy);
+	inline static float GetDefaultAnisotropy() { return s_DefaultAnisotropy; }
+
+	// Bytes of one width x height level in an internal format Set* uploads
+	static size_t GetImageSize(unsigned int format, int width, int height);
+	// Bytes of every level and layer uploaded (from the base level on)
+	size_t GetMemorySize() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetTarget() const { return m_Target; }
+	inline int GetLayerCount() const { return m_Layers; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline TextureMipmaps GetMipmaps() const { return m_Mipmaps; }
+	inline int GetLevelCount() const { return m_LevelCount; }
+	inline int GetBaseLevel() const { return m_BaseLevel; }
+	inline float GetMinLod() const { return m_MinLod; }
+	inline int GetDroppedLevels() const { return m_DroppedLevels; }
+	inline unsigned int GetFormat() const { return m_Format; }
+	inline bool IsCompressed() const { return m_Compressed; }
+	inline float GetAnisotropy() const { return m_Anisotropy; }
+	// Still showing the placeholder while a loader works on it
+	inline bool IsLoading() const { return m_Loader != nullptr; }
+	// Loaded, but a loader still holds finer levels to add on request
+	inline bool IsStreaming() const { return m_Streamer != nullptr; }
+	// Bumped by every Bind, so a caller can tell which textures were drawn with
+	inline unsigned int GetBindCount() const { return m_BindCount; }
+
+};
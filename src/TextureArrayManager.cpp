@@ -0,0 +1,103 @@
+#include "TextureArrayManager.h"
+
+#include "AssetPack.h"
+#include "MipGenerator.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureArrayManager::TextureArrayManager(unsigned int layersPerArray /*= DefaultLayersPerArray*/)
+{
+	int maxLayers = 256;
+	GLCall(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers));
+	m_LayersPerArray = std::min(std::max(layersPerArray, 1u), static_cast<unsigned int>(maxLayers));
+}
+
+TextureArrayManager::~TextureArrayManager()
+{
+}
+
+TextureLayer TextureArrayManager::Add(const MipChain& chain)
+{
+	TextureLayer result;
+	if (chain.levels.empty())
+		return result;
+	const int width = chain.levels[0].width;
+	const int height = chain.levels[0].height;
+
+	// The fullest array of this size with room keeps the others free to go
+	Array* target = nullptr;
+	for (Array& array : m_Arrays)
+	{
+		if (array.texture->GetWidth() != width || array.texture->GetHeight() != height || array.used == m_LayersPerArray)
+			continue;
+		if (!target || array.used > target->used)
+			target = &array;
+	}
+	if (!target)
+	{
+		m_Arrays.emplace_back();
+		target = &m_Arrays.back();
+		target->texture = std::make_unique<Texture>(width, height, static_cast<int>(m_LayersPerArray));
+		for (unsigned int layer = m_LayersPerArray; layer > 0; layer--)
+			target->freeLayers.push_back(layer - 1);
+	}
+
+	result.array = target->texture.get();
+	result.layer = target->freeLayers.back();
+	target->freeLayers.pop_back();
+	target->used++;
+	target->texture->SetLayer(static_cast<int>(result.layer), chain, chain.pixels.data());
+	return result;
+}
+
+TextureLayer TextureArrayManager::Load(const std::string& path)
+{
+	MipChain chain;
+	if (!MipGenerator::LoadCached(path, chain))
+	{
+		int width = 0, height = 0, channels = 0;
+		stbi_set_flip_vertically_on_load(1);
+		const AssetView asset = AssetPack::FindMounted(path);
+		unsigned char* pixels = asset
+			? stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(asset.data), static_cast<int>(asset.size), &width, &height, &channels, 4)
+			: stbi_load(path.c_str(), &width, &height, &channels, 4);
+		if (!pixels)
+		{
+			std::cout << "Failed to load " << path << ": "
+				<< (stbi_failure_reason() ? stbi_failure_reason() : "unknown error") << std::endl;
+			return TextureLayer();
+		}
+		MipGenerator::Build(pixels, width, height, chain);
+		MipGenerator::StoreCached(path, chain);
+		stbi_image_free(pixels);
+	}
+	return Add(chain);
+}
+
+void TextureArrayManager::Release(const TextureLayer& layer)
+{
+	auto array = std::find_if(m_Arrays.begin(), m_Arrays.end(),
+		[&layer](const Array& candidate) { return candidate.texture.get() == layer.array; });
+	if (array == m_Arrays.end())
+		return;
+
+	array->freeLayers.push_back(layer.layer);
+	if (--array->used == 0)
+		m_Arrays.erase(array);
+}
+
+TextureArrayStats TextureArrayManager::GetStats() const
+{
+	TextureArrayStats stats;
+	stats.arrays = static_cast<unsigned int>(m_Arrays.size());
+	for (const Array& array : m_Arrays)
+	{
+		stats.layersUsed += array.used;
+		stats.layersFree += m_LayersPerArray - array.used;
+	}
+	return stats;
+}
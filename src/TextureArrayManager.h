@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Texture;
+struct MipChain;
+
+// A slot in one of the manager's arrays
+struct TextureLayer
+{
+	const Texture* array = nullptr;		// a GL_TEXTURE_2D_ARRAY; null if the add failed
+	unsigned int layer = 0;				// for the shader's layer attribute
+
+	inline bool IsValid() const { return array != nullptr; }
+};
+
+struct TextureArrayStats
+{
+	unsigned int arrays = 0;
+	unsigned int layersUsed = 0;
+	unsigned int layersFree = 0;		// allocated in arrays but released
+};
+
+// Groups same-sized images into GL_TEXTURE_2D_ARRAY textures, for images
+// that can't go on an atlas because they repeat or need their own mips.
+// One binding then serves every layer: an instanced or batched draw picks
+// the image per instance/vertex by layer index (see CubeInstanced.shader).
+//
+// Each size gets arrays of LayersPerArray layers (storage for all of them
+// is allocated up front) and a new array when those are full. Released
+// layers go back on their array's free list for the next image of that
+// size; an array whose last layer is released is deleted. Handles must
+// not be used after Release, nor once the manager is gone.
+class TextureArrayManager
+{
+public:
+	static constexpr unsigned int DefaultLayersPerArray = 16;
+
+private:
+	struct Array
+	{
+		std::unique_ptr<Texture> texture;
+		std::vector<unsigned int> freeLayers;	// reused last-released first
+		unsigned int used = 0;
+	};
+
+	unsigned int m_LayersPerArray;
+	std::vector<Array> m_Arrays;
+public:
+	// Clamped to GL_MAX_ARRAY_TEXTURE_LAYERS
+	explicit TextureArrayManager(unsigned int layersPerArray = DefaultLayersPerArray);
+	~TextureArrayManager();
+
+	TextureArrayManager(const TextureArrayManager&) = delete;
+	TextureArrayManager& operator=(const TextureArrayManager&) = delete;
+
+	// Copies a full mip chain (MipGenerator::Build) into a free layer
+	TextureLayer Add(const MipChain& chain);
+	// Decodes path and adds it, using and filling the .mips cache
+	TextureLayer Load(const std::string& path);
+	void Release(const TextureLayer& layer);
+
+	TextureArrayStats GetStats() const;
+};
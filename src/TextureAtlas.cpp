@@ -0,0 +1,357 @@
+#include "TextureAtlas.h"
+
+#include "AssetPack.h"
+#include "MipGenerator.h"
+#include "Texture.h"
+#include "stb_image/stb_image.h"
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+	struct CacheHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t pageSize;
+		std::uint32_t padding;
+		std::uint32_t sources;
+		std::uint32_t pages;
+	};
+	// Then per source: size, write time, path; per region: page, x, y,
+	// width, height; per page: level count, level sizes, pixels
+
+	constexpr char CacheMagic[4] = { 'O', 'G', 'T', 'A' };
+	// Bump when the layout or the packing changes
+	constexpr std::uint32_t CacheVersion = 1;
+
+	// An image's pixels on its page, inside the padding
+	struct Placement
+	{
+		std::uint32_t page;
+		std::uint32_t x, y, width, height;		// width 0: not packed
+	};
+
+	int AlignUp(int value, int alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	size_t GetLevelCount(int padding)
+	{
+		size_t levels = 1;
+		for (int step = 1; step < padding; step *= 2)
+			levels++;
+		return levels;
+	}
+
+	bool LoadCache(const std::string& cachePath, const std::vector<std::string>& sources, int pageSize, int padding,
+		std::vector<Placement>& placements, std::vector<MipChain>& pages)
+	{
+		std::ifstream file(cachePath, std::ios::binary);
+		if (!file)
+			return false;
+		auto read = [&file](void* target, size_t size) {
+			return static_cast<bool>(file.read(static_cast<char*>(target), size));
+		};
+
+		CacheHeader header;
+		if (!read(&header, sizeof(header)) ||
+			std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+			header.version != CacheVersion ||
+			header.pageSize != std::uint32_t(pageSize) || header.padding != std::uint32_t(padding) ||
+			header.sources != sources.size() || header.pages > 1024)
+		{
+			return false;
+		}
+
+		for (const std::string& source : sources)
+		{
+			std::uint64_t size = 0, cachedSize = 0;
+			std::int64_t time = 0, cachedTime = 0;
+			std::uint32_t length = 0;
+			if (!AssetPack::GetSourceStamp(source, size, time) ||
+				!read(&cachedSize, sizeof(cachedSize)) || !read(&cachedTime, sizeof(cachedTime)) ||
+				!read(&length, sizeof(length)) || length != source.size() ||
+				cachedSize != size || cachedTime != time)
+			{
+				return false;
+			}
+			std::string path(length, '\0');
+			if (!read(&path[0], length) || path != source)
+				return false;
+		}
+
+		placements.resize(sources.size());
+		for (Placement& placement : placements)
+		{
+			if (!read(&placement, sizeof(placement)) || (placement.width > 0 && placement.page >= header.pages))
+				return false;
+		}
+
+		pages.resize(header.pages);
+		for (MipChain& page : pages)
+		{
+			std::uint32_t levelCount = 0;
+			if (!read(&levelCount, sizeof(levelCount)) || levelCount == 0 || levelCount > 16)
+				return false;
+			size_t offset = 0;
+			for (std::uint32_t i = 0; i < levelCount; i++)
+			{
+				std::uint32_t size[2];
+				if (!read(size, sizeof(size)) || size[0] == 0 || size[1] == 0 ||
+					size[0] > std::uint32_t(pageSize) || size[1] > std::uint32_t(pageSize))
+				{
+					return false;
+				}
+				page.levels.push_back({ int(size[0]), int(size[1]), offset });
+				offset += size_t(size[0]) * size[1] * 4;
+			}
+			page.pixels.resize(offset);
+			if (!read(page.pixels.data(), offset))
+				return false;
+		}
+
+		// Every placement must lie on its page
+		for (const Placement& placement : placements)
+		{
+			if (placement.width > 0 &&
+				(placement.x + placement.width > std::uint32_t(pages[placement.page].levels[0].width) ||
+				 placement.y + placement.height > std::uint32_t(pages[placement.page].levels[0].height)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void StoreCache(const std::string& cachePath, const std::vector<std::string>& sources, int pageSize, int padding,
+		const std::vector<Placement>& placements, const std::vector<MipChain>& pages)
+	{
+		CacheHeader header = {};
+		std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+		header.version = CacheVersion;
+		header.pageSize = std::uint32_t(pageSize);
+		header.padding = std::uint32_t(padding);
+		header.sources = std::uint32_t(sources.size());
+		header.pages = std::uint32_t(pages.size());
+
+		// Write to a temporary and rename, so a reader never sees half an entry
+		const std::string temporary = cachePath + ".tmp";
+		std::error_code error;
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return;
+			auto write = [&file](const void* source, size_t size) {
+				file.write(static_cast<const char*>(source), size);
+			};
+
+			write(&header, sizeof(header));
+			for (const std::string& source : sources)
+			{
+				std::uint64_t size = 0;
+				std::int64_t time = 0;
+				AssetPack::GetSourceStamp(source, size, time);
+				const std::uint32_t length = std::uint32_t(source.size());
+				write(&size, sizeof(size));
+				write(&time, sizeof(time));
+				write(&length, sizeof(length));
+				write(source.data(), length);
+			}
+			for (const Placement& placement : placements)
+				write(&placement, sizeof(placement));
+			for (const MipChain& page : pages)
+			{
+				const std::uint32_t levelCount = std::uint32_t(page.levels.size());
+				write(&levelCount, sizeof(levelCount));
+				for (const MipLevel& level : page.levels)
+				{
+					const std::uint32_t size[2] = { std::uint32_t(level.width), std::uint32_t(level.height) };
+					write(size, sizeof(size));
+				}
+				write(page.pixels.data(), page.pixels.size());
+			}
+
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(temporary, error);
+				return;
+			}
+		}
+		std::filesystem::rename(temporary, cachePath, error);
+		if (error)
+			std::filesystem::remove(temporary, error);
+	}
+
+	// Decodes, packs and mipmaps; returns false if any image was left out
+	bool Pack(const std::vector<std::string>& sources, int pageSize, int padding,
+		std::vector<Placement>& placements, std::vector<MipChain>& pages)
+	{
+		struct Image
+		{
+			unsigned char* pixels = nullptr;
+			int width = 0, height = 0;
+		};
+		std::vector<Image> images(sources.size());
+		std::vector<stbrp_rect> remaining;
+		bool complete = true;
+
+		// Bottom-up, like every other texture
+		stbi_set_flip_vertically_on_load(1);
+		for (size_t i = 0; i < sources.size(); i++)
+		{
+			Image& image = images[i];
+			int channels = 0;
+			const AssetView asset = AssetPack::FindMounted(sources[i]);
+			image.pixels = asset
+				? stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(asset.data), static_cast<int>(asset.size), &image.width, &image.height, &channels, 4)
+				: stbi_load(sources[i].c_str(), &image.width, &image.height, &channels, 4);
+			if (!image.pixels)
+			{
+				std::cout << "Atlas: failed to load " << sources[i] << ": "
+					<< (stbi_failure_reason() ? stbi_failure_reason() : "unknown error") << std::endl;
+				complete = false;
+				continue;
+			}
+
+			// Cells are aligned to the padding, so they stay apart down to the last level
+			stbrp_rect rect = {};
+			rect.id = static_cast<int>(i);
+			rect.w = AlignUp(image.width + 2 * padding, padding);
+			rect.h = AlignUp(image.height + 2 * padding, padding);
+			if (rect.w > pageSize || rect.h > pageSize)
+			{
+				std::cout << "Atlas: " << sources[i] << " (" << image.width << "x" << image.height
+					<< ") does not fit a " << pageSize << " page" << std::endl;
+				complete = false;
+				continue;
+			}
+			remaining.push_back(rect);
+		}
+
+		placements.assign(sources.size(), Placement());
+		pages.clear();
+		std::vector<stbrp_node> nodes(pageSize);
+		while (!remaining.empty())
+		{
+			stbrp_context context;
+			stbrp_init_target(&context, pageSize, pageSize, nodes.data(), static_cast<int>(nodes.size()));
+			stbrp_pack_rects(&context, remaining.data(), static_cast<int>(remaining.size()));
+
+			std::vector<stbrp_rect> packed, next;
+			int width = padding, height = padding;
+			for (const stbrp_rect& rect : remaining)
+			{
+				if (!rect.was_packed)
+				{
+					next.push_back(rect);
+					continue;
+				}
+				packed.push_back(rect);
+				width = std::max(width, rect.x + rect.w);
+				height = std::max(height, rect.y + rect.h);
+			}
+
+			// Each image fits an empty page, so every pass places at least one
+			const std::uint32_t page = static_cast<std::uint32_t>(pages.size());
+			std::vector<unsigned char> pixels(size_t(width) * height * 4, 0);
+			for (const stbrp_rect& rect : packed)
+			{
+				const Image& image = images[rect.id];
+				placements[rect.id] = { page, std::uint32_t(rect.x + padding), std::uint32_t(rect.y + padding),
+					std::uint32_t(image.width), std::uint32_t(image.height) };
+
+				// The whole cell, with the image's edges repeated outwards
+				for (int y = 0; y < rect.h; y++)
+				{
+					const int sourceY = std::min(std::max(y - padding, 0), image.height - 1);
+					unsigned char* target = pixels.data() + (size_t(rect.y + y) * width + rect.x) * 4;
+					for (int x = 0; x < rect.w; x++, target += 4)
+					{
+						const int sourceX = std::min(std::max(x - padding, 0), image.width - 1);
+						std::memcpy(target, image.pixels + (size_t(sourceY) * image.width + sourceX) * 4, 4);
+					}
+				}
+			}
+
+			pages.emplace_back();
+			MipGenerator::Build(pixels.data(), width, height, pages.back(), GetLevelCount(padding));
+			remaining = std::move(next);
+		}
+
+		for (Image& image : images)
+			stbi_image_free(image.pixels);
+		return complete;
+	}
+
+}
+
+TextureAtlas::TextureAtlas(int pageSize /*= DefaultPageSize*/, int padding /*= DefaultPadding*/)
+	: m_PageSize(pageSize), m_Padding(1), m_Cached(false)
+{
+	while (m_Padding < padding)
+		m_Padding *= 2;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+unsigned int TextureAtlas::Add(const std::string& path)
+{
+	m_Sources.push_back(path);
+	m_Regions.emplace_back();
+	return static_cast<unsigned int>(m_Sources.size() - 1);
+}
+
+bool TextureAtlas::Build(const std::string& cachePath /*= std::string()*/)
+{
+	std::vector<Placement> placements;
+	std::vector<MipChain> pages;
+	bool complete = true;
+
+	m_Cached = !cachePath.empty() && LoadCache(cachePath, m_Sources, m_PageSize, m_Padding, placements, pages);
+	if (!m_Cached)
+	{
+		complete = Pack(m_Sources, m_PageSize, m_Padding, placements, pages);
+		if (!cachePath.empty())
+			StoreCache(cachePath, m_Sources, m_PageSize, m_Padding, placements, pages);
+	}
+
+	m_Pages.clear();
+	for (const MipChain& chain : pages)
+	{
+		m_Pages.push_back(std::make_unique<Texture>(TextureMipmaps::Precomputed));
+		m_Pages.back()->SetMipChain(chain, chain.pixels.data());
+	}
+
+	for (size_t i = 0; i < placements.size(); i++)
+	{
+		const Placement& placement = placements[i];
+		AtlasRegion& region = m_Regions[i];
+		region = AtlasRegion();
+		if (placement.width == 0)
+		{
+			complete = false;
+			continue;
+		}
+		const glm::vec2 pageSize(pages[placement.page].levels[0].width, pages[placement.page].levels[0].height);
+		region.page = placement.page;
+		region.uvRect = glm::vec4(placement.x / pageSize.x, placement.y / pageSize.y,
+			(placement.x + placement.width) / pageSize.x, (placement.y + placement.height) / pageSize.y);
+		region.width = static_cast<int>(placement.width);
+		region.height = static_cast<int>(placement.height);
+	}
+	return complete;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Texture;
+
+// Where a packed image ended up
+struct AtlasRegion
+{
+	unsigned int page = 0;
+	glm::vec4 uvRect = glm::vec4(0.0f);	// (u0, v0, u1, v1), as SpriteBatch::Submit takes it
+	int width = 0, height = 0;			// source image size; 0 if it failed to load or fit
+};
+
+// Packs many images into a few large textures, so quads drawn from
+// different images can share one binding (and one SpriteBatch draw).
+//
+//	TextureAtlas atlas;
+//	unsigned int ship = atlas.Add("res/textures/ship.png");
+//	atlas.Build("res/textures/sprites.atlas");
+//	batch.Submit(position, size, 0.0f, atlas.GetPage(atlas.GetRegion(ship).page), color,
+//		atlas.GetRegion(ship).uvRect);
+//
+// Images are placed with imstb_rectpack on pages of up to PageSize
+// squared, each trimmed to what it uses. Every image gets a border of
+// padding pixels repeating its edge, and cells are aligned to the padding,
+// so bilinear filtering never reaches a neighbour. Pages carry gamma-
+// correct mips (MipGenerator), but only 1 + log2(padding) levels: past
+// that a texel would cover more than one image.
+//
+// Build writes the packed pages to cachePath; later builds with the same
+// images (by path, size and write time) read them back instead of
+// decoding and packing.
+class TextureAtlas
+{
+public:
+	static constexpr int DefaultPageSize = 2048;
+	static constexpr int DefaultPadding = 16;
+
+private:
+	int m_PageSize;
+	int m_Padding;				// a power of two
+	std::vector<std::string> m_Sources;
+	std::vector<AtlasRegion> m_Regions;
+	std::vector<std::unique_ptr<Texture>> m_Pages;
+	bool m_Cached;
+public:
+	// padding is rounded up to a power of two
+	explicit TextureAtlas(int pageSize = DefaultPageSize, int padding = DefaultPadding);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// Queues an image for Build; the handle indexes GetRegion
+	unsigned int Add(const std::string& path);
+
+	// Packs and uploads every image added so far, replacing earlier pages.
+	// Returns false if any image could not be loaded or is too big for a
+	// page; it keeps an empty region and the rest are still packed.
+	bool Build(const std::string& cachePath = std::string());
+
+	inline const AtlasRegion& GetRegion(unsigned int handle) const { return m_Regions[handle]; }
+	inline const Texture* GetPage(unsigned int page) const { return m_Pages[page].get(); }
+	inline unsigned int GetPageCount() const { return static_cast<unsigned int>(m_Pages.size()); }
+	inline unsigned int GetRegionCount() const { return static_cast<unsigned int>(m_Regions.size()); }
+	inline int GetPadding() const { return m_Padding; }
+	// Whether the last Build came from the cache
+	inline bool IsCached() const { return m_Cached; }
+};
@@ -0,0 +1,396 @@
+#include "TextureCompressor.h"
+
+#include "AssetPack.h"
+#include "MipGenerator.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace {
+
+	struct ContainerHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint32_t format;			// GL internal format
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint32_t levels;
+		std::uint64_t sourceSize;		// bytes of the image file
+		std::int64_t sourceTime;		// its write time, in file_time_type ticks
+		std::uint64_t dataOffset;		// start of the block data, 16-byte aligned
+	};
+
+	struct ContainerLevel
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint64_t offset;			// from dataOffset
+		std::uint64_t size;
+	};
+
+	constexpr char ContainerMagic[4] = { 'O', 'G', 'T', 'C' };
+	// Bump when the layout or the encoder changes
+	constexpr std::uint32_t ContainerVersion = 1;
+	constexpr size_t DataAlignment = 16;
+
+	size_t GetBlockBytes(unsigned int format)
+	{
+		return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+	}
+
+	size_t GetLevelSize(unsigned int format, int width, int height)
+	{
+		return size_t((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+	}
+
+	std::uint16_t ToRgb565(const float colour[3])
+	{
+		const int r = std::min(std::max(static_cast<int>(colour[0] * (31.0f / 255.0f) + 0.5f), 0), 31);
+		const int g = std::min(std::max(static_cast<int>(colour[1] * (63.0f / 255.0f) + 0.5f), 0), 63);
+		const int b = std::min(std::max(static_cast<int>(colour[2] * (31.0f / 255.0f) + 0.5f), 0), 31);
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void FromRgb565(std::uint16_t colour, int rgb[3])
+	{
+		const int r = (colour >> 11) & 31, g = (colour >> 5) & 63, b = colour & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	void WriteLittleEndian(unsigned char* target, std::uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			target[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+
+	// 8 bytes: two RGB565 endpoints along the principal axis, 2-bit indices.
+	// Always four-colour mode, as BC3 requires.
+	void EncodeColourBlock(const unsigned char block[16][4], unsigned char* target)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 3; c++)
+				mean[c] += block[i][c];
+		for (int c = 0; c < 3; c++)
+			mean[c] /= 16.0f;
+
+		float covariance[6] = {};		// rr rg rb gg gb bb
+		for (int i = 0; i < 16; i++)
+		{
+			const float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+			covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+			covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+		}
+
+		// A few power iterations find the axis closely enough
+		float axis[3] = { 0.577f, 0.577f, 0.577f };
+		for (int iteration = 0; iteration < 4; iteration++)
+		{
+			const float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			const float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			const float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			const float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (length < 1e-6f)
+				break;
+			axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+		}
+		const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		for (int c = 0; c < 3; c++)
+			axis[c] /= axisLength;
+
+		float lowest = 0.0f, highest = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			const float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+			lowest = std::min(lowest, t);
+			highest = std::max(highest, t);
+		}
+		float high[3], low[3];
+		for (int c = 0; c < 3; c++)
+		{
+			high[c] = mean[c] + axis[c] * highest;
+			low[c] = mean[c] + axis[c] * lowest;
+		}
+
+		std::uint16_t colour0 = ToRgb565(high), colour1 = ToRgb565(low);
+		if (colour0 < colour1)
+			std::swap(colour0, colour1);
+
+		std::uint32_t indices = 0;
+		if (colour0 != colour1)
+		{
+			int palette[4][3];
+			FromRgb565(colour0, palette[0]);
+			FromRgb565(colour1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0, bestError = 1 << 30;
+				for (int p = 0; p < 4; p++)
+				{
+					const int r = block[i][0] - palette[p][0], g = block[i][1] - palette[p][1], b = block[i][2] - palette[p][2];
+					const int error = r * r + g * g + b * b;
+					if (error < bestError)
+					{
+						best = p;
+						bestError = error;
+					}
+				}
+				indices |= std::uint32_t(best) << (2 * i);
+			}
+		}
+
+		WriteLittleEndian(target, colour0, 2);
+		WriteLittleEndian(target + 2, colour1, 2);
+		WriteLittleEndian(target + 4, indices, 4);
+	}
+
+	// 8 bytes: alpha endpoints (eight-value mode) and 3-bit indices
+	void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char* target)
+	{
+		int alpha0 = 0, alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, int(block[i][3]));
+			alpha1 = std::min(alpha1, int(block[i][3]));
+		}
+
+		std::uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			int palette[8] = { alpha0, alpha1 };
+			for (int p = 1; p < 7; p++)
+				palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0, bestError = 256;
+				for (int p = 0; p < 8; p++)
+				{
+					const int error = std::abs(block[i][3] - palette[p]);
+					if (error < bestError)
+					{
+						best = p;
+						bestError = error;
+					}
+				}
+				indices |= std::uint64_t(best) << (3 * i);
+			}
+		}
+
+		target[0] = static_cast<unsigned char>(alpha0);
+		target[1] = static_cast<unsigned char>(alpha1);
+		WriteLittleEndian(target + 2, indices, 6);
+	}
+
+	// Edge blocks repeat the last row/column
+	void FetchBlock(const unsigned char* pixels, int width, int height, int blockX, int blockY, unsigned char block[16][4])
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			const int sourceY = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				const int sourceX = std::min(blockX * 4 + x, width - 1);
+				std::memcpy(block[y * 4 + x], pixels + (size_t(sourceY) * width + sourceX) * 4, 4);
+			}
+		}
+	}
+
+	std::string CachePath(const std::string& imagePath)
+	{
+		return imagePath + TextureCompressor::CacheExtension;
+	}
+
+}
+
+bool TextureCompressor::IsSupported()
+{
+	return GLEW_EXT_texture_compression_s3tc;
+}
+
+void TextureCompressor::Encode(const MipChain& chain, CompressedImage& image, unsigned int threadCount /*= 0*/)
+{
+	image.file.reset();
+	image.levels.clear();
+	image.storage.clear();
+	image.data = nullptr;
+	if (chain.levels.empty())
+		return;
+
+	bool opaque = true;
+	const MipLevel& base = chain.levels[0];
+	const unsigned char* basePixels = chain.GetLevel(0);
+	for (size_t i = 0; i < size_t(base.width) * base.height && opaque; i++)
+		opaque = basePixels[i * 4 + 3] == 255;
+	image.format = opaque ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+	// One task per row of blocks, across every level
+	struct Row
+	{
+		size_t level;
+		int blockY;
+	};
+	std::vector<Row> rows;
+	size_t offset = 0;
+	for (size_t i = 0; i < chain.levels.size(); i++)
+	{
+		const MipLevel& level = chain.levels[i];
+		const size_t size = GetLevelSize(image.format, level.width, level.height);
+		image.levels.push_back({ level.width, level.height, offset, size });
+		offset += size;
+		for (int y = 0; y < (level.height + 3) / 4; y++)
+			rows.push_back({ i, y });
+	}
+	image.storage.resize(offset);
+	image.data = image.storage.data();
+
+	const size_t blockBytes = GetBlockBytes(image.format);
+	std::atomic<size_t> nextRow(0);
+	auto work = [&]() {
+		unsigned char block[16][4];
+		for (size_t row = nextRow++; row < rows.size(); row = nextRow++)
+		{
+			const MipLevel& level = chain.levels[rows[row].level];
+			const int blocksWide = (level.width + 3) / 4;
+			unsigned char* target = image.storage.data() + image.levels[rows[row].level].offset +
+				size_t(rows[row].blockY) * blocksWide * blockBytes;
+			for (int x = 0; x < blocksWide; x++, target += blockBytes)
+			{
+				FetchBlock(chain.GetLevel(rows[row].level), level.width, level.height, x, rows[row].blockY, block);
+				if (opaque)
+				{
+					EncodeColourBlock(block, target);
+				}
+				else
+				{
+					EncodeAlphaBlock(block, target);
+					EncodeColourBlock(block, target + 8);
+				}
+			}
+		}
+	};
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, rows.size()));
+	std::vector<std::thread> helpers;
+	for (unsigned int i = 1; i < threadCount; i++)
+		helpers.emplace_back(work);
+	work();
+	for (std::thread& helper : helpers)
+		helper.join();
+}
+
+bool TextureCompressor::LoadCached(const std::string& imagePath, CompressedImage& image)
+{
+	std::uint64_t sourceSize = 0;
+	std::int64_t sourceTime = 0;
+	if (!AssetPack::GetSourceStamp(imagePath, sourceSize, sourceTime))
+		return false;
+
+	auto file = std::make_unique<MappedFile>(CachePath(imagePath));
+	if (file->GetSize() < sizeof(ContainerHeader))
+		return false;
+
+	ContainerHeader header;
+	std::memcpy(&header, file->GetData(), sizeof(header));
+	if (std::memcmp(header.magic, ContainerMagic, sizeof(ContainerMagic)) != 0 ||
+		header.version != ContainerVersion ||
+		header.sourceSize != sourceSize || header.sourceTime != sourceTime ||
+		(header.format != GL_COMPRESSED_RGB_S3TC_DXT1_EXT && header.format != GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ||
+		header.levels == 0 || header.levels > 32 ||
+		header.dataOffset < sizeof(header) + header.levels * sizeof(ContainerLevel) ||
+		header.dataOffset > file->GetSize())
+	{
+		return false;
+	}
+
+	// Sizes are checked against the format, so a damaged file can't point
+	// the upload past the mapping
+	const size_t dataSize = file->GetSize() - header.dataOffset;
+	std::vector<CompressedLevel> levels;
+	for (std::uint32_t i = 0; i < header.levels; i++)
+	{
+		ContainerLevel level;
+		std::memcpy(&level, file->GetData() + sizeof(header) + i * sizeof(ContainerLevel), sizeof(level));
+		if (level.width == 0 || level.height == 0 || level.width > 65536 || level.height > 65536 ||
+			level.size != GetLevelSize(header.format, level.width, level.height) ||
+			level.offset > dataSize || level.size > dataSize - level.offset)
+		{
+			return false;
+		}
+		levels.push_back({ static_cast<int>(level.width), static_cast<int>(level.height),
+			static_cast<size_t>(level.offset), static_cast<size_t>(level.size) });
+	}
+
+	file->Prefetch();
+	image.format = header.format;
+	image.levels = std::move(levels);
+	image.storage.clear();
+	image.data = reinterpret_cast<const unsigned char*>(file->GetData()) + header.dataOffset;
+	image.file = std::move(file);
+	return true;
+}
+
+void TextureCompressor::StoreCached(const std::string& imagePath, const CompressedImage& image)
+{
+	ContainerHeader header = {};
+	if (image.levels.empty() || !AssetPack::GetSourceStamp(imagePath, header.sourceSize, header.sourceTime))
+		return;
+	std::memcpy(header.magic, ContainerMagic, sizeof(ContainerMagic));
+	header.version = ContainerVersion;
+	header.format = image.format;
+	header.width = static_cast<std::uint32_t>(image.levels[0].width);
+	header.height = static_cast<std::uint32_t>(image.levels[0].height);
+	header.levels = static_cast<std::uint32_t>(image.levels.size());
+	const size_t tableEnd = sizeof(header) + image.levels.size() * sizeof(ContainerLevel);
+	header.dataOffset = (tableEnd + DataAlignment - 1) / DataAlignment * DataAlignment;
+
+	std::vector<unsigned char> prefix(header.dataOffset, 0);
+	std::memcpy(prefix.data(), &header, sizeof(header));
+	for (size_t i = 0; i < image.levels.size(); i++)
+	{
+		const CompressedLevel& level = image.levels[i];
+		const ContainerLevel record = { static_cast<std::uint32_t>(level.width), static_cast<std::uint32_t>(level.height),
+			level.offset, level.size };
+		std::memcpy(prefix.data() + sizeof(header) + i * sizeof(ContainerLevel), &record, sizeof(record));
+	}
+
+	// Write to a temporary and rename, so a reader never maps half an entry
+	const std::string path = CachePath(imagePath);
+	// Per thread: two workers may be storing the same image at once
+	const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::error_code error;
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+		file.write(reinterpret_cast<const char*>(prefix.data()), prefix.size());
+		file.write(reinterpret_cast<const char*>(image.data), image.GetSize());
+		if (!file)
+		{
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+		std::filesystem::remove(temporary, error);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+struct MipChain;
+
+struct CompressedLevel
+{
+	int width;
+	int height;
+	size_t offset;		// into CompressedImage::data
+	size_t size;
+};
+
+// A block-compressed image and its mips, either encoded in memory or
+// mapped straight from a container file
+struct CompressedImage
+{
+	unsigned int format = 0;				// GL internal format (S3TC DXT1 or DXT5)
+	std::vector<CompressedLevel> levels;	// [0] is the full-size image
+	const unsigned char* data = nullptr;
+	std::vector<unsigned char> storage;		// backs data after Encode
+	std::unique_ptr<MappedFile> file;		// backs data after LoadCached
+
+	inline size_t GetSize() const { return levels.empty() ? 0 : levels.back().offset + levels.back().size; }
+};
+
+// BCn texture import: encodes a MipChain as BC1 (opaque images) or BC3
+// (anything with alpha), spread over a thread per core, and stores the
+// result next to the image as "<image>.bcn" so later loads map it and hand
+// the blocks to glCompressedTexImage2D without decoding anything.
+//
+// The container is a small header, one record per level and 16-byte
+// aligned block data, keyed on the image's size and write time like the
+// mip cache. Encoding fits each 4x4 block's endpoints along its principal
+// colour axis; it is tuned for import speed, not best quality.
+class TextureCompressor
+{
+public:
+	static constexpr const char* CacheExtension = ".bcn";
+
+	// S3TC is an extension on GL 3.3; call on the GL thread
+	static bool IsSupported();
+
+	// threadCount 0 uses every hardware thread; callers that already run
+	// several encodes at once (the loader's workers) should pass 1
+	static void Encode(const MipChain& chain, CompressedImage& image, unsigned int threadCount = 0);
+
+	static bool LoadCached(const std::string& imagePath, CompressedImage& image);
+	// Failures (read-only directories, ...) only cost the next load
+	static void StoreCached(const std::string& imagePath, const CompressedImage& image);
+};
@@ -0,0 +1,466 @@
+#include "TextureLoader.h"
+
+#include "AssetPack.h"
+#include "Texture.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "TextureCompressor.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <sys/resource.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+static double NowMilliseconds()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Removes the count largest levels, always keeping the last
+static int DropLevels(MipChain& chain, int count)
+{
+	count = std::min(count, static_cast<int>(chain.levels.size()) - 1);
+	if (count <= 0)
+		return 0;
+	const size_t begin = chain.levels[count].offset;
+	chain.levels.erase(chain.levels.begin(), chain.levels.begin() + count);
+	for (MipLevel& level : chain.levels)
+		level.offset -= begin;
+	chain.pixels.erase(chain.pixels.begin(), chain.pixels.begin() + begin);
+	return count;
+}
+
+// The first level a streamed texture starts with
+template <typename Level>
+static int GetStreamedBaseLevel(const std::vector<Level>& levels)
+{
+	int level = 0;
+	while (level + 1 < static_cast<int>(levels.size()) &&
+		std::max(levels[level].width, levels[level].height) > TextureLoader::StreamedTailSize)
+	{
+		level++;
+	}
+	return level;
+}
+
+static int DropLevels(CompressedImage& image, int count)
+{
+	count = std::min(count, static_cast<int>(image.levels.size()) - 1);
+	if (count <= 0)
+		return 0;
+	// The blocks stay where they are (mapped or encoded); data moves past the dropped ones
+	const size_t begin = image.levels[count].offset;
+	image.levels.erase(image.levels.begin(), image.levels.begin() + count);
+	for (CompressedLevel& level : image.levels)
+		level.offset -= begin;
+	image.data += begin;
+	return count;
+}
+
+TextureLoader::TextureLoader(unsigned int workerCount)
+	: m_Stopping(false), m_NextTicket(0), m_Stream(UploadBytesPerFrame), m_Compress(TextureCompressor::IsSupported())
+{
+	if (workerCount == 0)
+	{
+		// The main thread keeps one core for rendering
+		const unsigned int hardware = std::thread::hardware_concurrency();
+		workerCount = std::min(std::max(hardware, 2u) - 1, 4u);
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+		m_Workers.emplace_back(&TextureLoader::WorkerLoop, this);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+		worker.join();
+
+	for (auto& pending : m_Pending)
+		pending.second->m_Loader = nullptr;
+	for (auto& stream : m_Streams)
+		stream.second.texture->m_Streamer = nullptr;
+}
+
+std::unique_ptr<Texture> TextureLoader::Load(const std::string& path)
+{
+	return Load(path, TextureMipmaps::Precomputed);
+}
+
+std::unique_ptr<Texture> TextureLoader::Load(const std::string& path, TextureMipmaps mipmaps)
+{
+	std::unique_ptr<Texture> texture = std::make_unique<Texture>(mipmaps);
+	texture->m_FilePath = path;
+	Queue(*texture, mipmaps, 0, false);
+	return texture;
+}
+
+std::unique_ptr<Texture> TextureLoader::LoadStreamed(const std::string& path)
+{
+	std::unique_ptr<Texture> texture = std::make_unique<Texture>(TextureMipmaps::Precomputed);
+	texture->m_FilePath = path;
+	Queue(*texture, TextureMipmaps::Precomputed, 0, true);
+	return texture;
+}
+
+void TextureLoader::RequestFootprint(const Texture& texture, float pixels)
+{
+	auto stream = m_Streams.find(&texture);
+	if (stream == m_Streams.end())
+		return;
+
+	// Trilinear filtering reads floor(lod) and the level after it
+	const float texels = static_cast<float>(std::max(texture.GetWidth(), texture.GetHeight()));
+	int level = texture.GetLevelCount() - 1;
+	if (pixels >= texels)
+		level = 0;
+	else if (pixels > 0.0f)
+		level = std::min(static_cast<int>(std::log2(texels / pixels)), level);
+	stream->second.requested = std::min(stream->second.requested, level);
+}
+
+void TextureLoader::Reload(Texture& texture, int droppedLevels /*= 0*/)
+{
+	if (texture.m_FilePath.empty())
+		return;
+	if (texture.m_Loader)
+		texture.m_Loader->Cancel(texture);
+	if (texture.m_Streamer)
+		texture.m_Streamer->Cancel(texture);
+	Queue(texture, texture.GetMipmaps(), texture.GetMipmaps() == TextureMipmaps::Precomputed ? droppedLevels : 0, false);
+	m_Stats.reloads++;
+}
+
+void TextureLoader::Queue(Texture& texture, TextureMipmaps mipmaps, int droppedLevels, bool stream)
+{
+	texture.m_Loader = this;
+	texture.m_LoadTicket = ++m_NextTicket;
+	m_Pending[texture.m_LoadTicket] = &texture;
+	m_Stats.queued++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back({ texture.m_LoadTicket, texture.m_FilePath, mipmaps,
+			m_Compress && mipmaps == TextureMipmaps::Precomputed, droppedLevels, stream });
+	}
+	m_WorkAvailable.notify_one();
+}
+
+void TextureLoader::SetCompression(bool enabled)
+{
+	m_Compress = enabled && TextureCompressor::IsSupported();
+}
+
+void TextureLoader::Cancel(Texture& texture)
+{
+	if (texture.m_Streamer == this)
+	{
+		m_Streams.erase(&texture);
+		texture.m_Streamer = nullptr;
+	}
+	if (texture.m_Loader != this)
+		return;
+
+	const unsigned int ticket = texture.m_LoadTicket;
+	m_Pending.erase(ticket);
+	texture.m_Loader = nullptr;
+
+	// A decode already running finishes and is dropped in Update
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Jobs.erase(std::remove_if(m_Jobs.begin(), m_Jobs.end(),
+		[ticket](const Job& job) { return job.ticket == ticket; }), m_Jobs.end());
+}
+
+void TextureLoader::WorkerLoop()
+{
+	// Decoding is never urgent; the render thread wins any contention
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+	setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+
+	// Textures are stored bottom-up, like the synchronous path
+	stbi_set_flip_vertically_on_load_thread(1);
+
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+			if (m_Stopping)
+				return;
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		Decoded decoded;
+		decoded.ticket = job.ticket;
+		decoded.stream = job.stream;
+		const bool precomputed = job.mipmaps == TextureMipmaps::Precomputed;
+		if (job.compress)
+			decoded.cached = TextureCompressor::LoadCached(job.path, decoded.compressed);
+		else if (precomputed)
+			decoded.cached = MipGenerator::LoadCached(job.path, decoded.chain);
+		if (!decoded.cached)
+		{
+			int width = 0, height = 0, channels = 0;
+			const AssetView asset = AssetPack::FindMounted(job.path);
+			unsigned char* pixels = asset
+				? stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(asset.data), static_cast<int>(asset.size), &width, &height, &channels, 4)
+				: stbi_load(job.path.c_str(), &width, &height, &channels, 4);
+			if (!pixels)
+			{
+				decoded.error = stbi_failure_reason() ? stbi_failure_reason() : "unknown error";
+			}
+			else if (job.compress)
+			{
+				MipChain chain;
+				MipGenerator::Build(pixels, width, height, chain);
+				// One thread: the workers already encode images side by side
+				TextureCompressor::Encode(chain, decoded.compressed, 1);
+				TextureCompressor::StoreCached(job.path, decoded.compressed);
+			}
+			else if (precomputed)
+			{
+				MipGenerator::Build(pixels, width, height, decoded.chain);
+				MipGenerator::StoreCached(job.path, decoded.chain);
+			}
+			else
+			{
+				decoded.chain.levels.push_back({ width, height, 0 });
+				decoded.chain.pixels.assign(pixels, pixels + size_t(width) * height * 4);
+			}
+			stbi_image_free(pixels);
+		}
+
+		// After caching, so the cache always holds the full chain
+		if (job.droppedLevels > 0)
+		{
+			decoded.droppedLevels = job.compress ? DropLevels(decoded.compressed, job.droppedLevels)
+				: DropLevels(decoded.chain, job.droppedLevels);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Decoded.push_back(std::move(decoded));
+	}
+}
+
+void TextureLoader::Update()
+{
+	Upload(BudgetMilliseconds);
+}
+
+void TextureLoader::Finish()
+{
+	while (!m_Pending.empty())
+	{
+		Upload(0.0);
+		if (!m_Pending.empty())
+			std::this_thread::yield();
+	}
+}
+
+void TextureLoader::Upload(double budgetMilliseconds)
+{
+	const double start = NowMilliseconds();
+	unsigned int frameBytes = 0;
+	bool streamed = false;
+
+	for (;;)
+	{
+		if (budgetMilliseconds > 0.0 && frameBytes > 0 && NowMilliseconds() - start >= budgetMilliseconds)
+			break;
+
+		Decoded decoded;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Decoded.empty())
+				break;
+
+			// The rest of this frame's upload space; an image that doesn't fit waits
+			// for the next frame, unless it is the first (larger than a whole frame)
+			const Decoded& next = m_Decoded.front();
+			const unsigned int size = static_cast<unsigned int>(next.chain.pixels.size() + next.compressed.GetSize());
+			if (frameBytes > 0 && frameBytes + size > UploadBytesPerFrame)
+				break;
+			decoded = std::move(m_Decoded.front());
+			m_Decoded.pop_front();
+		}
+
+		auto pending = m_Pending.find(decoded.ticket);
+		if (pending == m_Pending.end())
+			continue;		// cancelled while decoding
+		Texture* texture = pending->second;
+		m_Pending.erase(pending);
+		texture->m_Loader = nullptr;
+
+		if (decoded.chain.levels.empty() && decoded.compressed.levels.empty())
+		{
+			std::cout << "Failed to load " << texture->GetFilePath() << ": " << decoded.error << std::endl;
+			m_Stats.failed++;
+			continue;
+		}
+
+		if (!decoded.compressed.levels.empty())
+		{
+			// Already GPU-sized: straight from the mapping (or encoder output)
+			const int baseLevel = decoded.stream ? GetStreamedBaseLevel(decoded.compressed.levels) : 0;
+			texture->SetCompressedImage(decoded.compressed, baseLevel);
+			texture->m_DroppedLevels = decoded.droppedLevels;
+			const unsigned int size = static_cast<unsigned int>(decoded.compressed.GetSize() -
+				decoded.compressed.levels[baseLevel].offset);
+			if (decoded.cached)
+				m_Stats.compressedCacheHits++;
+			m_Stats.compressed++;
+			frameBytes += size;
+			m_Stats.loaded++;
+			m_Stats.bytesUploaded += size;
+			if (baseLevel > 0)
+			{
+				m_Streams[texture] = { texture, MipChain(), std::move(decoded.compressed), INT_MAX, 0.0f };
+				texture->m_Streamer = this;
+				m_Stats.streamed++;
+			}
+			continue;
+		}
+
+		const MipChain& chain = decoded.chain;
+		const int levelCount = static_cast<int>(chain.levels.size());
+		const int baseLevel = decoded.stream ? GetStreamedBaseLevel(chain.levels) : 0;
+		const unsigned int size = static_cast<unsigned int>(chain.pixels.size() - chain.levels[baseLevel].offset);
+		const void* pixels = Stage(chain, baseLevel, levelCount, streamed);
+		if (levelCount > 1)
+			texture->SetMipChain(chain, pixels, baseLevel);
+		else
+			texture->SetImage(chain.levels[0].width, chain.levels[0].height, pixels);
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		texture->m_DroppedLevels = decoded.droppedLevels;
+
+		if (texture->GetMipmaps() == TextureMipmaps::Precomputed)
+		{
+			if (decoded.cached)
+				m_Stats.mipCacheHits++;
+			else
+				m_Stats.mipsBuilt++;
+		}
+		frameBytes += size;
+		m_Stats.loaded++;
+		m_Stats.bytesUploaded += size;
+		if (baseLevel > 0)
+		{
+			m_Streams[texture] = { texture, std::move(decoded.chain), CompressedImage(), INT_MAX, 0.0f };
+			texture->m_Streamer = this;
+			m_Stats.streamed++;
+		}
+	}
+
+	UploadStreamedLevels(start, budgetMilliseconds, frameBytes, streamed);
+
+	// The fence keeps the segment from being rewritten before the GPU has read it
+	if (streamed)
+		m_Stream.EndFrame();
+	m_Stats.lastUpdateMs = NowMilliseconds() - start;
+}
+
+void TextureLoader::UploadStreamedLevels(double start, double budgetMilliseconds, unsigned int& frameBytes, bool& streamed)
+{
+	for (auto entry = m_Streams.begin(); entry != m_Streams.end();)
+	{
+		Stream& stream = entry->second;
+		Texture& texture = *stream.texture;
+		if (stream.fade > 0.0f)
+		{
+			stream.fade = std::max(stream.fade - LodFadePerUpdate, 0.0f);
+			texture.SetMinLod(stream.fade);
+		}
+
+		// One level at a time, coarse to fine, so a texture sharpens evenly
+		const int level = texture.GetBaseLevel() - 1;
+		const bool withinTime = budgetMilliseconds <= 0.0 || frameBytes == 0 ||
+			NowMilliseconds() - start < budgetMilliseconds;
+		if (stream.requested <= level && withinTime)
+		{
+			// With the coarser levels (see Texture::AddLevels)
+			const bool compressed = !stream.compressed.levels.empty();
+			const unsigned int size = static_cast<unsigned int>(compressed
+				? stream.compressed.GetSize() - stream.compressed.levels[level].offset
+				: stream.chain.pixels.size() - stream.chain.levels[level].offset);
+			if (frameBytes == 0 || frameBytes + size <= UploadBytesPerFrame)
+			{
+				if (compressed)
+				{
+					texture.AddLevels(stream.compressed, level);
+				}
+				else
+				{
+					const int levelCount = static_cast<int>(stream.chain.levels.size());
+					texture.AddLevels(stream.chain, Stage(stream.chain, level, levelCount, streamed), level);
+					GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				}
+
+				// Sampled exactly as before, then blended towards the new level
+				stream.fade += 1.0f;
+				texture.SetMinLod(stream.fade);
+				frameBytes += size;
+				m_Stats.levelsStreamed++;
+				m_Stats.bytesUploaded += size;
+			}
+		}
+		stream.requested = INT_MAX;
+
+		// Complete: the chain (or mapping) is no longer needed
+		if (texture.GetBaseLevel() == 0 && stream.fade == 0.0f)
+		{
+			texture.m_Streamer = nullptr;
+			entry = m_Streams.erase(entry);
+		}
+		else
+		{
+			++entry;
+		}
+	}
+}
+
+const void* TextureLoader::Stage(const MipChain& chain, int first, int last, bool& streamed)
+{
+	const size_t begin = chain.levels[first].offset;
+	const size_t end = last < static_cast<int>(chain.levels.size()) ? chain.levels[last].offset : chain.pixels.size();
+	const unsigned int size = static_cast<unsigned int>(end - begin);
+
+	// Bigger than a frame's upload space: straight from client memory
+	if (size > UploadBytesPerFrame)
+		return chain.pixels.data();
+
+	if (!streamed)
+	{
+		m_Stream.BeginFrame();
+		streamed = true;
+	}
+	const StreamAllocation allocation = m_Stream.Upload(chain.pixels.data() + begin, size, 4);
+	if (!allocation.data)
+		return chain.pixels.data();
+
+	// Texture adds each level's offset in the chain; the allocation starts at
+	// level first, so the base is moved back by its offset (modulo arithmetic)
+	m_Stream.Bind(GL_PIXEL_UNPACK_BUFFER);
+	return reinterpret_cast<const void*>(static_cast<std::uintptr_t>(allocation.offset) - begin);
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MipGenerator.h"
+#include "StreamBuffer.h"
+#include "TextureCompressor.h"
+
+class Texture;
+enum class TextureMipmaps;
+
+struct TextureLoaderStats
+{
+	unsigned int queued = 0;		// loads requested
+	unsigned int loaded = 0;		// images uploaded
+	unsigned int failed = 0;		// files that could not be decoded (they keep the placeholder)
+	unsigned int mipsBuilt = 0;		// precomputed chains downsampled (and cached) by the workers
+	unsigned int mipCacheHits = 0;	// precomputed chains read back from "<image>.mips"
+	unsigned int compressed = 0;			// textures uploaded block-compressed
+	unsigned int compressedCacheHits = 0;	// of those, mapped from "<image>.bcn"
+	unsigned int reloads = 0;		// of the loads, Reload requests
+	unsigned int streamed = 0;		// uploaded coarse levels first (LoadStreamed)
+	unsigned int levelsStreamed = 0;	// finer levels added since, for RequestFootprint
+	unsigned long long bytesUploaded = 0;
+	double lastUpdateMs = 0.0;		// main-thread time of the last Update
+};
+
+// Loads image files without blocking the render loop.
+//
+// Load returns a texture at once, showing a 1x1 placeholder. A pool of
+// worker threads decodes the file (stb_image) and builds its mip chain
+// (MipGenerator, or the cached chain instead), then block-compresses it
+// (TextureCompressor) unless compression is off; Update, called once per
+// frame on the GL thread, then copies decoded images into a StreamBuffer
+// used as a pixel unpack buffer and issues glTexImage2D from it, so the
+// driver transfers the pixels asynchronously (compressed images, a
+// fraction of the size, go to glCompressedTexImage2D straight from their
+// mapped cache file). Update stops after
+// BudgetMilliseconds or a frame's worth of upload space (at least one
+// image per frame always goes through), so a burst of loads is spread
+// over several frames instead of stalling one.
+//
+// LoadStreamed textures start with just their levels of at most
+// StreamedTailSize, so a large scene shows something at once for a
+// fraction of the upload; the loader keeps the rest of the chain (the .bcn
+// stays mapped) and adds finer levels, a level per texture per Update
+// within the same budget, down to the finest one RequestFootprint has
+// asked for. GL_TEXTURE_BASE_LEVEL keeps sampling to the levels that are
+// there, and GL_TEXTURE_MIN_LOD fades each new one in over a few frames
+// instead of popping. Levels nothing asks for are never uploaded.
+//
+// The texture keeps its GL name throughout, so anything holding it (sprite
+// batches, draw packets) picks up the image without noticing. Destroying
+// a texture cancels its load; the loader must outlive its textures.
+class TextureLoader
+{
+public:
+	static constexpr double BudgetMilliseconds = 2.0;
+	static constexpr unsigned int UploadBytesPerFrame = 8 * 1024 * 1024;
+	// Streamed textures start with the levels no larger than this
+	static constexpr int StreamedTailSize = 64;
+	// How fast a streamed level blends in, in levels per Update
+	static constexpr float LodFadePerUpdate = 0.125f;
+
+private:
+	struct Job
+	{
+		unsigned int ticket;
+		std::string path;
+		TextureMipmaps mipmaps;
+		bool compress;
+		int droppedLevels;
+		bool stream;
+	};
+
+	struct Decoded
+	{
+		unsigned int ticket;
+		MipChain chain;				// just level 0 unless mipmaps are precomputed; empty on failure
+		CompressedImage compressed;	// instead of chain, for compressed loads
+		bool cached = false;		// came from the mip or BCn cache
+		int droppedLevels = 0;		// left off the front of chain or compressed
+		bool stream = false;
+		std::string error;
+	};
+
+	// The rest of a streamed texture's levels
+	struct Stream
+	{
+		Texture* texture;
+		MipChain chain;
+		CompressedImage compressed;	// instead of chain, for compressed loads
+		int requested;				// finest level asked for since the last Update
+		float fade;					// GL_TEXTURE_MIN_LOD still to blend away
+	};
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::deque<Job> m_Jobs;						// guarded by m_Mutex
+	std::deque<Decoded> m_Decoded;				// guarded by m_Mutex
+	bool m_Stopping;
+
+	// GL thread only
+	std::unordered_map<unsigned int, Texture*> m_Pending;	// by ticket
+	std::unordered_map<const Texture*, Stream> m_Streams;
+	unsigned int m_NextTicket;
+	StreamBuffer m_Stream;
+	TextureLoaderStats m_Stats;
+	bool m_Compress;
+
+	void Queue(Texture& texture, TextureMipmaps mipmaps, int droppedLevels, bool stream);
+	void WorkerLoop();
+	// Uploads decoded images until the budget runs out; 0 disables the time limit
+	void Upload(double budgetMilliseconds);
+	// Then streamed levels, with what the budget has left
+	void UploadStreamedLevels(double start, double budgetMilliseconds, unsigned int& frameBytes, bool& streamed);
+	// Copies levels [first, last) of chain into the stream buffer and binds it
+	// as the unpack buffer; returns the pixels argument for Texture (chain's
+	// own memory, with nothing bound, if they don't fit)
+	const void* Stage(const MipChain& chain, int first, int last, bool& streamed);
+public:
+	// workerCount 0 picks one per spare hardware thread (at most 4)
+	explicit TextureLoader(unsigned int workerCount = 0);
+	~TextureLoader();
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	std::unique_ptr<Texture> Load(const std::string& path, TextureMipmaps mipmaps);
+	// With a precomputed mip chain
+	std::unique_ptr<Texture> Load(const std::string& path);
+	// With a precomputed mip chain, coarsest levels first (see above)
+	std::unique_ptr<Texture> LoadStreamed(const std::string& path);
+	// The texture is drawn this frame at about pixels across (for its longer
+	// side's full UV range), so levels down to texels / pixels are wanted.
+	// Cheap; call it per draw. Ignored for textures that aren't streaming.
+	void RequestFootprint(const Texture& texture, float pixels);
+	// Loads texture's file into it again, without its droppedLevels largest
+	// mip levels (precomputed chains only; others always load in full), and
+	// not streamed. It keeps showing its current image until the new one is
+	// uploaded. Used by TextureResidency to shrink textures and restore them.
+	void Reload(Texture& texture, int droppedLevels = 0);
+	void Cancel(Texture& texture);
+
+	// Block-compress textures with precomputed mips (on by default where
+	// S3TC is supported); applies to loads requested afterwards
+	void SetCompression(bool enabled);
+	inline bool IsCompressing() const { return m_Compress; }
+
+	// Once per frame, on the GL thread
+	void Update();
+	// Blocks until every requested texture is uploaded (loading screens, benchmarks)
+	void Finish();
+
+	inline unsigned int GetPendingCount() const { return static_cast<unsigned int>(m_Pending.size()); }
+	inline unsigned int GetStreamingCount() const { return static_cast<unsigned int>(m_Streams.size()); }
+	inline const TextureLoaderStats& GetStats() const { return m_Stats; }
+};
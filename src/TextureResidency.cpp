@@ -0,0 +1,152 @@
+#include "TextureResidency.h"
+
+#include "Texture.h"
+#include "TextureLoader.h"
+
+#include <algorithm>
+
+TextureResidency::TextureResidency(TextureLoader& loader, size_t budgetBytes)
+	: m_Loader(loader), m_Budget(budgetBytes), m_Frame(0)
+{
+	m_Stats.budget = budgetBytes;
+}
+
+TextureResidency::~TextureResidency()
+{
+}
+
+void TextureResidency::Add(Texture& texture)
+{
+	Entry entry = {};
+	entry.texture = &texture;
+	entry.bindCount = texture.GetBindCount();
+	entry.lastBound = m_Frame;
+	m_Entries.push_back(entry);
+}
+
+void TextureResidency::Remove(Texture& texture)
+{
+	m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(),
+		[&texture](const Entry& entry) { return entry.texture == &texture; }), m_Entries.end());
+}
+
+size_t TextureResidency::GetSize(const Entry& entry, int droppedLevels)
+{
+	// Until its file has been seen, what it has (the placeholder while loading)
+	if (entry.fullWidth == 0)
+		return entry.texture->GetMemorySize();
+	size_t size = 0;
+	for (int level = droppedLevels; level < entry.fullLevels; level++)
+	{
+		size += Texture::GetImageSize(entry.format,
+			std::max(entry.fullWidth >> level, 1), std::max(entry.fullHeight >> level, 1));
+	}
+	return size;
+}
+
+size_t TextureResidency::GetSize(const Entry& entry)
+{
+	return entry.evicted ? entry.texture->GetMemorySize() : GetSize(entry, entry.droppedLevels);
+}
+
+void TextureResidency::Update()
+{
+	m_Frame++;
+	size_t total = 0;
+	for (Entry& entry : m_Entries)
+	{
+		Texture& texture = *entry.texture;
+		if (!texture.IsLoading() && !entry.evicted)
+		{
+			// Level 0 of the file, as far as the levels dropped from it tell
+			entry.fullWidth = texture.GetWidth() << texture.GetDroppedLevels();
+			entry.fullHeight = texture.GetHeight() << texture.GetDroppedLevels();
+			entry.fullLevels = texture.GetLevelCount() + texture.GetDroppedLevels();
+			entry.format = texture.GetFormat();
+		}
+
+		if (texture.GetBindCount() != entry.bindCount)
+		{
+			entry.bindCount = texture.GetBindCount();
+			entry.lastBound = m_Frame - 1;
+			if (entry.evicted || entry.droppedLevels > 0)
+			{
+				m_Loader.Reload(texture);
+				entry.evicted = false;
+				entry.droppedLevels = 0;
+				m_Stats.restores++;
+			}
+		}
+		total += GetSize(entry);
+	}
+
+	if (total > m_Budget)
+	{
+		// Least recently bound first; what the last frame drew stays
+		std::vector<Entry*> candidates;
+		for (Entry& entry : m_Entries)
+		{
+			if (entry.lastBound < m_Frame - 1 && !entry.evicted && entry.fullWidth > 0)
+				candidates.push_back(&entry);
+		}
+		std::stable_sort(candidates.begin(), candidates.end(),
+			[](const Entry* a, const Entry* b) { return a->lastBound < b->lastBound; });
+
+		// Blurry before gone: drop top levels from each, while they stay at
+		// least MinimumSize, and only then evict. Planned first, so nothing
+		// evicted is reloaded smaller on the way.
+		std::vector<int> dropped(candidates.size());
+		for (size_t i = 0; i < candidates.size(); i++)
+		{
+			const Entry& entry = *candidates[i];
+			dropped[i] = entry.droppedLevels;
+			if (total <= m_Budget || entry.texture->GetMipmaps() != TextureMipmaps::Precomputed)
+				continue;
+			const size_t size = GetSize(entry);
+			while (total - size + GetSize(entry, dropped[i]) > m_Budget && dropped[i] + 1 < entry.fullLevels &&
+				std::max(entry.fullWidth >> (dropped[i] + 1), entry.fullHeight >> (dropped[i] + 1)) >= MinimumSize)
+			{
+				dropped[i]++;
+			}
+			total += GetSize(entry, dropped[i]) - size;
+		}
+
+		size_t evictions = 0;
+		for (; evictions < candidates.size() && total > m_Budget; evictions++)
+		{
+			Entry& entry = *candidates[evictions];
+			total -= GetSize(entry, dropped[evictions]);
+			// Nothing needs to be read back for this; a pending reduction is dropped
+			if (entry.texture->IsLoading())
+				m_Loader.Cancel(*entry.texture);
+			entry.texture->SetPlaceholder();
+			entry.evicted = true;
+			entry.droppedLevels = 0;
+			total += GetSize(entry);
+			m_Stats.evictions++;
+		}
+
+		for (size_t i = evictions; i < candidates.size(); i++)
+		{
+			Entry& entry = *candidates[i];
+			if (dropped[i] == entry.droppedLevels)
+				continue;
+			m_Loader.Reload(*entry.texture, dropped[i]);
+			entry.droppedLevels = dropped[i];
+			m_Stats.reductions++;
+		}
+	}
+
+	m_Stats.budget = m_Budget;
+	m_Stats.resident = total;
+	m_Stats.textures = static_cast<unsigned int>(m_Entries.size());
+	m_Stats.reduced = 0;
+	m_Stats.evicted = 0;
+	for (const Entry& entry : m_Entries)
+	{
+		if (entry.evicted)
+			m_Stats.evicted++;
+		else if (entry.droppedLevels > 0)
+			m_Stats.reduced++;
+	}
+}
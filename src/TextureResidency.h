@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class Texture;
+class TextureLoader;
+
+struct TextureResidencyStats
+{
+	size_t budget = 0;
+	size_t resident = 0;			// bytes of the tracked textures once pending reloads land
+	unsigned int textures = 0;
+	unsigned int reduced = 0;		// showing fewer levels than their file has
+	unsigned int evicted = 0;		// showing the placeholder
+	unsigned int reductions = 0;	// totals since creation
+	unsigned int evictions = 0;
+	unsigned int restores = 0;
+};
+
+// Keeps the textures it is given within a budget of GPU memory, so a
+// scene can use more image data than the machine holds at once.
+//
+// Each Update (once per frame, after the loader's) notes which textures
+// were bound since the last one, then, while the total is over budget,
+// shrinks the least recently bound: first by dropping their largest mip
+// levels, down to MinimumSize, through TextureLoader::Reload, then by
+// evicting them to the 1x1 placeholder. A shrunk texture that is bound
+// again is reloaded in full, showing what it has left (the placeholder,
+// if evicted) until then. Textures bound in the last frame are never
+// shrunk, so the budget can be exceeded by what a single frame draws.
+//
+// Sizes are what the textures' levels take as uploaded, per level (see
+// Texture::GetMemorySize); driver overhead and alignment are not counted.
+// Textures must come from the loader (they need their file to come back)
+// and must be removed before they are destroyed.
+class TextureResidency
+{
+public:
+	// Dropping mips stops here; the next step evicts
+	static constexpr int MinimumSize = 64;
+
+private:
+	struct Entry
+	{
+		Texture* texture;
+		unsigned int bindCount;			// as of the last Update
+		unsigned long long lastBound;	// Update index
+		int droppedLevels;				// requested; the texture catches up when its reload lands
+		bool evicted;
+		int fullWidth, fullHeight;		// of the file, once seen; 0 before
+		int fullLevels;
+		unsigned int format;
+	};
+
+	TextureLoader& m_Loader;
+	size_t m_Budget;
+	std::vector<Entry> m_Entries;
+	unsigned long long m_Frame;
+	TextureResidencyStats m_Stats;
+
+	// Bytes the texture will take with droppedLevels dropped
+	static size_t GetSize(const Entry& entry, int droppedLevels);
+	static size_t GetSize(const Entry& entry);
+public:
+	TextureResidency(TextureLoader& loader, size_t budgetBytes);
+	~TextureResidency();
+
+	TextureResidency(const TextureResidency&) = delete;
+	TextureResidency& operator=(const TextureResidency&) = delete;
+
+	void Add(Texture& texture);
+	// Stops tracking; a shrunk texture stays as it is
+	void Remove(Texture& texture);
+
+	// Takes effect on the next Update
+	inline void SetBudget(size_t budgetBytes) { m_Budget = budgetBytes; }
+	inline size_t GetBudget() const { return m_Budget; }
+
+	// Once per frame, on the GL thread
+	void Update();
+
+	inline const TextureResidencyStats& GetStats() const { return m_Stats; }
+};
@@ -0,0 +1,39 @@
+#include "UniformBuffer.h"
+
+#include "GLState.h"
+#include "StreamBuffer.h"
+
+static unsigned int GetOffsetAlignment()
+{
+	static GLint alignment = 0;
+	if (alignment == 0)
+	{
+		GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+		if (alignment <= 0)
+			alignment = 256; // largest value the spec allows
+	}
+	return static_cast<unsigned int>(alignment);
+}
+
+UniformBuffer::UniformBuffer(const UniformBufferLayout& layout, unsigned int binding)
+	: m_Layout(layout), m_Binding(binding), m_Data(layout.GetSize(), 0), m_BufferID(0), m_Offset(0)
+{
+}
+
+bool UniformBuffer::Upload(StreamBuffer& stream)
+{
+	StreamAllocation allocation = stream.Upload(m_Data.data(), static_cast<unsigned int>(m_Data.size()), GetOffsetAlignment());
+	if (!allocation.data)
+		return false;
+
+	m_BufferID = stream.GetRendererID();
+	m_Offset = allocation.offset;
+	return true;
+}
+
+void UniformBuffer::Bind() const
+{
+	if (m_BufferID == 0)
+		return;
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, m_Binding, m_BufferID, m_Offset, static_cast<unsigned int>(m_Data.size()));
+}
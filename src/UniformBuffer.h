@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "UniformBufferLayout.h"
+
+class StreamBuffer;
+
+// Uniform blocks shared by every shader. Shaders declare them as
+// layout(std140) with the members in the same order as the layouts built
+// for them; after linking, Shader binds any of these blocks it finds to the
+// fixed binding point listed here.
+struct UniformBlockBinding
+{
+	const char* name;
+	unsigned int binding;
+};
+
+constexpr UniformBlockBinding UNIFORM_BLOCK_FRAME = { "FrameData", 0 };	// time, lights
+constexpr UniformBlockBinding UNIFORM_BLOCK_VIEW = { "ViewData", 1 };	// camera matrices and position
+
+constexpr UniformBlockBinding UNIFORM_BLOCKS[] = { UNIFORM_BLOCK_FRAME, UNIFORM_BLOCK_VIEW };
+
+// CPU copy of a uniform block that is streamed to the GPU once per frame.
+// Members are set by offset (as returned by UniformBufferLayout::Push) or by
+// name; Upload copies the block into the renderer's stream buffer and Bind
+// attaches that range to the block's binding point, so several instances of
+// the same block (e.g. one per view) can be uploaded up front and switched
+// with a single bind.
+class UniformBuffer
+{
+private:
+	UniformBufferLayout m_Layout;
+	unsigned int m_Binding;
+	std::vector<unsigned char> m_Data;
+	unsigned int m_BufferID;	// buffer and range of the last Upload
+	unsigned int m_Offset;
+public:
+	UniformBuffer(const UniformBufferLayout& layout, unsigned int binding);
+
+	template<typename T>
+	void Set(unsigned int offset, const T& value)
+	{
+		ASSERT(offset + sizeof(T) <= m_Data.size());
+		std::memcpy(m_Data.data() + offset, &value, sizeof(T));
+	}
+
+	template<typename T>
+	void Set(const std::string& name, const T& value)
+	{
+		int offset = m_Layout.GetOffset(name);
+		ASSERT(offset >= 0);
+		if (offset >= 0)
+			Set(static_cast<unsigned int>(offset), value);
+	}
+
+	// Copies the block into the stream buffer; call once per frame after
+	// Renderer::BeginFrame. Returns false if the stream buffer is full.
+	bool Upload(StreamBuffer& stream);
+	// Binds the range of the last Upload to the block's binding point
+	void Bind() const;
+
+	inline const UniformBufferLayout& GetLayout() const { return m_Layout; }
+	inline unsigned int GetBinding() const { return m_Binding; }
+};
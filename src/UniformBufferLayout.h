@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+
+struct UniformBufferElement
+{
+	std::string name;
+	unsigned int type;
+	unsigned int offset;	// byte offset of the first element in the block
+	unsigned int count;		// array length, 1 for a plain member
+	unsigned int stride;	// byte distance between array elements
+};
+
+// Computes std140 offsets for a uniform block, in the order the members are
+// declared in GLSL:
+//
+//	UniformBufferLayout layout;
+//	layout.Push<glm::mat4>("u_ViewProjection");
+//	layout.Push<glm::vec3>("u_ViewPos");
+//	layout.Push<float>("u_Time");			// packs into the vec3's padding
+//
+// Push returns the member's offset so callers can keep it instead of looking
+// the name up. mat3 is left out on purpose: std140 pads each column to a
+// vec4, so a glm::mat3 can't be copied in as is.
+class UniformBufferLayout
+{
+private:
+	std::vector<UniformBufferElement> m_Elements;
+	unsigned int m_Size;
+public:
+	UniformBufferLayout()
+		: m_Size(0) {}
+
+	template<typename T>
+	unsigned int Push(const std::string& name, unsigned int count = 1)
+	{
+		static_assert(sizeof(T) == 0, "Unsupported type for UniformBufferLayout::Push");
+		return 0;
+	}
+
+	// Returns the member's offset, or -1 if the layout has no such member
+	int GetOffset(const std::string& name) const
+	{
+		for (const UniformBufferElement& element : m_Elements)
+			if (element.name == name)
+				return static_cast<int>(element.offset);
+		return -1;
+	}
+
+	inline const std::vector<UniformBufferElement>& GetElements() const { return m_Elements; }
+	// Block size; std140 rounds it up to a multiple of 16
+	inline unsigned int GetSize() const { return (m_Size + 15) & ~15u; }
+
+private:
+	// size/alignment are those of a single, non-array member. Array elements
+	// are rounded up to vec4 alignment and stride, and so is the array's end:
+	// the next member starts after the last element's padding (std140 rule 4).
+	unsigned int Append(const std::string& name, unsigned int type, unsigned int size, unsigned int alignment, unsigned int count)
+	{
+		unsigned int stride = size;
+		if (count > 1)
+		{
+			alignment = (alignment + 15) & ~15u;
+			stride = (size + 15) & ~15u;
+		}
+
+		const unsigned int offset = (m_Size + alignment - 1) / alignment * alignment;
+		m_Elements.push_back({ name, type, offset, count, stride });
+		m_Size = count > 1 ? offset + stride * count : offset + size;
+		return offset;
+	}
+};
+
+template<>
+inline unsigned int UniformBufferLayout::Push<float>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_FLOAT, 4, 4, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<int>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_INT, 4, 4, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<unsigned int>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_UNSIGNED_INT, 4, 4, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec2>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_FLOAT_VEC2, 8, 8, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec3>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_FLOAT_VEC3, 12, 16, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::vec4>(const std::string& name, unsigned int count)
+{
+	return Append(name, GL_FLOAT_VEC4, 16, 16, count);
+}
+
+template<>
+inline unsigned int UniformBufferLayout::Push<glm::mat4>(const std::string& name, unsigned int count)
+{
+	// Column-major: four vec4 columns
+	return Append(name, GL_FLOAT_MAT4, 64, 16, count);
+}
@@ -1,9 +1,11 @@
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "Renderer.h"
+#include "GLState.h"
 #include <cstdint>
 
 VertexArray::VertexArray()
+	: m_AttribCount(0)
 {
 	GLCall(glGenVertexArrays(1, &m_RendererID));
 }
@@ -11,30 +13,53 @@ VertexArray::VertexArray()
 VertexArray::~VertexArray()
 {
 	GLCall(glDeleteVertexArrays(1, &m_RendererID));
+	GLState::OnVertexArrayDeleted(m_RendererID);
 }
 
-void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+unsigned int VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	return AddBuffer(vb.GetRendererID(), layout, 0);
+}
+
+unsigned int VertexArray::AddBuffer(unsigned int buffer, const VertexBufferLayout& layout, unsigned int offset)
+{
+	const unsigned int firstAttrib = m_AttribCount;
+	SetupAttributes(buffer, layout, firstAttrib, offset);
+	m_AttribCount += static_cast<unsigned int>(layout.GetElements().size());
+	return firstAttrib;
+}
+
+void VertexArray::SetBufferOffset(unsigned int firstAttrib, unsigned int buffer, const VertexBufferLayout& layout, unsigned int offset)
+{
+	SetupAttributes(buffer, layout, firstAttrib, offset);
+}
+
+void VertexArray::SetupAttributes(unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstAttrib, unsigned int offset)
 {
 	Bind();
-	vb.Bind();
+	GLState::BindBuffer(GL_ARRAY_BUFFER, buffer);
 	const auto& elements = layout.GetElements();
-	unsigned int offset = 0;
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		const auto& element = elements[i];
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type,  element.normalized, layout.GetStride(), reinterpret_cast<const void*>(static_cast<uintptr_t>(offset))));
+		const unsigned int location = firstAttrib + i;
+		GLCall(glEnableVertexAttribArray(location));
+		GLCall(glVertexAttribPointer(location, element.count, element.type,  element.normalized, layout.GetStride(), reinterpret_cast<const void*>(static_cast<uintptr_t>(offset))));
+		if (layout.GetDivisor() != 0)
+		{
+			GLCall(glVertexAttribDivisor(location, layout.GetDivisor()));
+		}
 		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
 	}
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::BindVertexArray(m_RendererID);
 };
 
 void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	GLState::BindVertexArray(0);
 
 };
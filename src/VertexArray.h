@@ -8,13 +8,25 @@ class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_AttribCount;
+
+	void SetupAttributes(unsigned int buffer, const VertexBufferLayout& layout, unsigned int firstAttrib, unsigned int offset);
 public:
 	VertexArray();
 	~VertexArray();
 
-	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// Attributes of each added buffer continue at the next free location.
+	// Returns the location of the buffer's first attribute.
+	unsigned int AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	unsigned int AddBuffer(unsigned int buffer, const VertexBufferLayout& layout, unsigned int offset = 0);
+
+	// Re-points attributes added earlier at another buffer and/or byte offset,
+	// e.g. at this frame's range of a StreamBuffer
+	void SetBufferOffset(unsigned int firstAttrib, unsigned int buffer, const VertexBufferLayout& layout, unsigned int offset);
 
 	void Bind() const;
 
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 };
\ No newline at end of file
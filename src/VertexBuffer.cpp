@@ -1,27 +1,46 @@
 #include "VertexBuffer.h"
 
 #include "Renderer.h"
+#include "GLState.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size) 
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, unsigned int usage) 
+	: m_Size(size), m_Usage(usage)
 {
 	GLCall(glGenBuffers(1, &m_RendererID));
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID)); //Buffer binding is FUNDAMENTAL
-	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID); //Buffer binding is FUNDAMENTAL
+	GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, usage));
 }
 
 VertexBuffer::~VertexBuffer() 
 {
 	GLCall(glDeleteBuffers(1, &m_RendererID));
+	GLState::OnBufferDeleted(m_RendererID);
 }
 
 void VertexBuffer::Bind() const 
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID)); //Buffer binding is FUNDAMENTAL
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID); //Buffer binding is FUNDAMENTAL
 
 }
 
 void VertexBuffer::Unbind() const	
 {
-	GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0)); //Buffer binding is FUNDAMENTAL
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0); //Buffer binding is FUNDAMENTAL
 
+}
+
+void VertexBuffer::SetData(const void* data, unsigned int size)
+{
+	Bind();
+	if (size > m_Size)
+		m_Size = size;
+	GLCall(glBufferData(GL_ARRAY_BUFFER, m_Size, nullptr, m_Usage)); // orphan
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, 0, size, data));
+}
+
+void VertexBuffer::SetSubData(const void* data, unsigned int size, unsigned int offset)
+{
+	ASSERT(offset + size <= m_Size);
+	Bind();
+	GLCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
 }
\ No newline at end of file
@@ -1,14 +1,28 @@
 #pragma once
 
+#include <GL/glew.h>
+
 class VertexBuffer 
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_Size;
+	unsigned int m_Usage;
 public:
-	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(const void* data, unsigned int size, unsigned int usage = GL_STATIC_DRAW);
 	~VertexBuffer();
 
 	void Bind() const;
 	void Unbind() const;
 
+	// Replaces the buffer contents. The old storage is orphaned first, so the
+	// driver never has to wait for draws still reading the previous data.
+	void SetData(const void* data, unsigned int size);
+	// Writes into part of the buffer in place, e.g. to fill a buffer created
+	// with null data. Not meant for data the GPU may still be reading.
+	void SetSubData(const void* data, unsigned int size, unsigned int offset);
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline unsigned int GetSize() const { return m_Size; }
+
 };
\ No newline at end of file
@@ -33,18 +33,21 @@ class VertexBufferLayout
 private:
 	std::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride;
+	unsigned int m_Divisor;
 public:
-	VertexBufferLayout()
-		: m_Stride(0) {}
+	// divisor 0 advances attributes per vertex, N advances them once every N instances
+	VertexBufferLayout(unsigned int divisor = 0)
+		: m_Stride(0), m_Divisor(divisor) {}
 
 	template<typename T>
 	void Push(unsigned int count)
 	{
-		static_assert(false, "Unsupported type for VertexBufferLayout::Push");
+		static_assert(sizeof(T) == 0, "Unsupported type for VertexBufferLayout::Push");
 	}
 
-	inline const std::vector<VertexBufferElement> GetElements() const& { return m_Elements; }
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
+	inline unsigned int GetDivisor() const { return m_Divisor; }
 };
 
 template<>
@@ -1,15 +1,103 @@
 #include "Application.h"
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
-int main() {
-    OpenGLApp app;
+static void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --headless          Render offscreen (EGL or hidden window), vsync off,\n"
+              << "                      and print frame-time statistics as JSON\n"
+              << "  --frames N          Measured frames in headless mode (default 600)\n"
+              << "  --warmup N          Unmeasured frames before that (default 60)\n"
+              << "  --output FILE       Write the JSON report to FILE instead of stdout\n"
+              << "  --sprites N         Moving sprites in the 2D stress test\n"
+              << "  --instances N       Show the instanced cube grid with N instances\n"
+              << "  --mixed             Draw the instance grid as mixed meshes (multi-draw)\n"
+              << "  --cube              Show the single rotating cube\n"
+              << "  --no-quads          Hide the 2D quads and sprites\n"
+              << "  --load-textures N   Stream N textures in the background while running\n"
+              << "  --no-compression    Upload textures as RGBA8 instead of BCn\n"
+              << "  --texture-budget MB Keep textures within MB of GPU memory, shrinking unused ones\n"
+              << "  --stream-textures   Load coarse mips first, finer ones as on-screen size needs\n"
+              << "  --pack FILE         Read assets from FILE (e.g. res.pack) instead of res/;\n"
+              << "                      turns shader hot reload off\n"
+              << "  --help              Show this message\n";
+}
+
+int main(int argc, char** argv) {
+    AppOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        // Options taking a value read the next argument
+        auto value = [&](int& target) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            target = std::atoi(argv[++i]);
+            return true;
+        };
+
+        bool ok = true;
+        if (std::strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(arg, "--frames") == 0) {
+            ok = value(options.frames);
+        } else if (std::strcmp(arg, "--warmup") == 0) {
+            ok = value(options.warmupFrames);
+        } else if (std::strcmp(arg, "--output") == 0) {
+            if (i + 1 < argc) {
+                options.output = argv[++i];
+            } else {
+                std::cerr << "Missing value for " << arg << std::endl;
+                ok = false;
+            }
+        } else if (std::strcmp(arg, "--sprites") == 0) {
+            ok = value(options.sprites);
+        } else if (std::strcmp(arg, "--instances") == 0) {
+            ok = value(options.instances);
+        } else if (std::strcmp(arg, "--mixed") == 0) {
+            options.mixedMeshes = true;
+        } else if (std::strcmp(arg, "--cube") == 0) {
+            options.cube = true;
+        } else if (std::strcmp(arg, "--no-quads") == 0) {
+            options.noQuads = true;
+        } else if (std::strcmp(arg, "--load-textures") == 0) {
+            ok = value(options.loadTextures);
+        } else if (std::strcmp(arg, "--no-compression") == 0) {
+            options.noCompression = true;
+        } else if (std::strcmp(arg, "--texture-budget") == 0) {
+            ok = value(options.textureBudget);
+        } else if (std::strcmp(arg, "--stream-textures") == 0) {
+            options.streamTextures = true;
+        } else if (std::strcmp(arg, "--pack") == 0) {
+            if (i + 1 < argc) {
+                options.assetPack = argv[++i];
+            } else {
+                std::cerr << "Missing value for " << arg << std::endl;
+                ok = false;
+            }
+        } else if (std::strcmp(arg, "--help") == 0) {
+            PrintUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            ok = false;
+        }
+
+        if (!ok) {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    OpenGLApp app(options);
 
     if (!app.Initialize()) {
         std::cerr << "Failed to initialize application" << std::endl;
         return -1;
     }
 
-    app.Run();
-
-    return 0;
-}
\ No newline at end of file
+    return app.Run();
+}
@@ -0,0 +1,31 @@
+#include "AssetPack.h"
+
+#include <cstring>
+#include <iostream>
+
+// Builds the asset pack the app mounts at startup (see AssetPack.h). Run
+// from the directory the app runs in, so the names match its paths.
+int main(int argc, char** argv)
+{
+	bool compress = false;
+	const char* paths[2] = {};
+	int count = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--compress") == 0)
+			compress = true;
+		else if (count < 2)
+			paths[count++] = argv[i];
+		else
+			count = 3;
+	}
+	if (count != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " <pack> <directory> [--compress]\n"
+				  << "  Packs every file under directory (but the loaders' caches) into pack;\n"
+				  << "  --compress stores files LZ4-compressed where that saves 1/"
+				  << AssetPack::MinimumSaving << " or more" << std::endl;
+		return 2;
+	}
+	return AssetPack::Write(paths[0], paths[1], compress) ? 0 : 1;
+}